@@ -82,7 +82,7 @@ cmd_attach_session_exec(struct cmd *self, struct cmd_ctx *ctx)
 		}
 
 		overrides =
-		    options_get_string(&s->options, "terminal-overrides");
+		    options_string(&s->options, OPTC_TERMINAL_OVERRIDES);
 		if (tty_open(&ctx->cmdclient->tty, overrides, &cause) != 0) {
 			ctx->error(ctx, "terminal open failed: %s", cause);
 			xfree(cause);
@@ -98,7 +98,7 @@ cmd_attach_session_exec(struct cmd *self, struct cmd_ctx *ctx)
 		ctx->cmdclient->session = s;
 		server_write_client(ctx->cmdclient, MSG_READY, NULL, 0);
 
-		update = options_get_string(&s->options, "update-environment");
+		update = options_string(&s->options, OPTC_UPDATE_ENVIRONMENT);
 		environ_update(update, &ctx->cmdclient->environ, &s->environ);
 
 		server_redraw_client(ctx->cmdclient);
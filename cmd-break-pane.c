@@ -72,7 +72,7 @@ cmd_break_pane_exec(struct cmd *self, struct cmd_ctx *ctx)
 	w->name = default_window_name(w);
 	layout_init(w);
 
-	base_idx = options_get_number(&s->options, "base-index");
+	base_idx = options_number(&s->options, OPTC_BASE_INDEX);
 	wl = session_attach(s, w, -1 - base_idx, &cause); /* can't fail */
 	if (!cmd_check_flag(data->chflags, 'd'))
 		session_select(s, wl->idx);
@@ -69,7 +69,7 @@ cmd_capture_pane_exec(struct cmd *self, struct cmd_ctx *ctx)
 	       xfree(line);
 	}
 
-	limit = options_get_number(&sess->options, "buffer-limit");
+	limit = options_number(&sess->options, OPTC_BUFFER_LIMIT);
 	if (data->buffer == -1) {
 		paste_add(&sess->buffers, buf, len, limit);
 		return (0);
@@ -148,7 +148,7 @@ cmd_copy_buffer_exec(struct cmd *self, struct cmd_ctx *ctx)
 		    	return (-1);
 		}
 	}
-	limit = options_get_number(&dst_session->options, "buffer-limit");
+	limit = options_number(&dst_session->options, OPTC_BUFFER_LIMIT);
 
 	pdata = xmalloc(pb->size);
 	memcpy(pdata, pb->data, pb->size);
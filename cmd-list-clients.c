@@ -57,9 +57,11 @@ cmd_list_clients_exec(unused struct cmd *self, struct cmd_ctx *ctx)
 			s_utf8 = " (utf8)";
 		else
 			s_utf8 = "";
-		ctx->print(ctx, "%s: %s [%ux%u %s]%s", c->tty.path,
-		    c->session->name, c->tty.sx, c->tty.sy,
-		    c->tty.termname, s_utf8);
+		ctx->print(ctx,
+		    "%s: %s [%ux%u %s]%s [queued %zu, dropped frames %u]",
+		    c->tty.path, c->session->name, c->tty.sx, c->tty.sy,
+		    c->tty.termname, s_utf8,
+		    (size_t) EVBUFFER_LENGTH(c->tty.event->output), c->dropped);
 	}
 
 	return (0);
@@ -46,9 +46,9 @@ cmd_list_panes_exec(struct cmd *self, struct cmd_ctx *ctx)
 	struct winlink		*wl;
 	struct window_pane	*wp;
 	struct grid		*gd;
-	struct grid_line	*gl;
-	u_int			 i, n;
+	u_int			 n, ratio;
 	unsigned long long	 size;
+	size_t			 bsize, bspilled, blinesize;
 
 	if ((wl = cmd_find_window(ctx, data->target, NULL)) == NULL)
 		return (-1);
@@ -57,16 +57,21 @@ cmd_list_panes_exec(struct cmd *self, struct cmd_ctx *ctx)
 	TAILQ_FOREACH(wp, &wl->window->panes, entry) {
 		gd = wp->base.grid;
 
-		size = 0;
-		for (i = 0; i < gd->hsize; i++) {
-			gl = &gd->linedata[i];
-			size += gl->cellsize * sizeof *gl->celldata;
-			size += gl->utf8size * sizeof *gl->utf8data;
-		}
-		size += gd->hsize * sizeof *gd->linedata;
+		size = grid_history_size(gd);
+		grid_block_sizes(gd, &bsize, &bspilled, &blinesize);
 
-		ctx->print(ctx, "%u: [%ux%u] [history %u/%u, %llu bytes]",
-		    n, wp->sx, wp->sy, gd->hsize, gd->hlimit, size);
+		if (gd->hcomp == 0) {
+			ctx->print(ctx, "%u: [%ux%u] [history %u/%u, %llu "
+			    "bytes]", n, wp->sx, wp->sy, gd->hsize, gd->hlimit,
+			    size);
+		} else {
+			ratio = (blinesize * 100) / (bsize + bspilled);
+			ctx->print(ctx, "%u: [%ux%u] [history %u/%u, %llu "
+			    "bytes] [compressed %u, ratio %u.%02u, %zu bytes "
+			    "on disk]", n, wp->sx, wp->sy, gd->hsize,
+			    gd->hlimit, size, gd->hcomp, ratio / 100,
+			    ratio % 100, bspilled);
+		}
 		n++;
 	}
 
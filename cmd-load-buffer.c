@@ -79,7 +79,7 @@ cmd_load_buffer_exec(struct cmd *self, struct cmd_ctx *ctx)
 
 	fclose(f);
 
-	limit = options_get_number(&s->options, "buffer-limit");
+	limit = options_number(&s->options, OPTC_BUFFER_LIMIT);
 	if (data->buffer == -1) {
 		paste_add(&s->buffers, pdata, psize, limit);
 		return (0);
@@ -187,7 +187,7 @@ cmd_new_session_exec(struct cmd *self, struct cmd_ctx *ctx)
 		}
 
 		overrides =
-		    options_get_string(&global_s_options, "terminal-overrides");
+		    options_string(&global_s_options, OPTC_TERMINAL_OVERRIDES);
 		if (tty_open(&ctx->cmdclient->tty, overrides, &cause) != 0) {
 			ctx->error(ctx, "open terminal failed: %s", cause);
 			xfree(cause);
@@ -199,7 +199,7 @@ cmd_new_session_exec(struct cmd *self, struct cmd_ctx *ctx)
 	if (ctx->cmdclient != NULL && ctx->cmdclient->cwd != NULL)
 		cwd = ctx->cmdclient->cwd;
 	else
-		cwd = options_get_string(&global_s_options, "default-path");
+		cwd = options_string(&global_s_options, OPTC_DEFAULT_PATH);
 
 	/* Find new session size. */
 	if (detached) {
@@ -212,7 +212,7 @@ cmd_new_session_exec(struct cmd *self, struct cmd_ctx *ctx)
 		sx = ctx->curclient->tty.sx;
 		sy = ctx->curclient->tty.sy;
 	}
-	if (sy > 0 && options_get_number(&global_s_options, "status"))
+	if (sy > 0 && options_number(&global_s_options, OPTC_STATUS))
 		sy--;
 	if (sx == 0)
 		sx = 1;
@@ -225,16 +225,16 @@ cmd_new_session_exec(struct cmd *self, struct cmd_ctx *ctx)
 	else if (data->cmd != NULL)
 		cmd = data->cmd;
 	else
-		cmd = options_get_string(&global_s_options, "default-command");
+		cmd = options_string(&global_s_options, OPTC_DEFAULT_COMMAND);
 
 	/* Construct the environment. */
 	environ_init(&env);
-	update = options_get_string(&global_s_options, "update-environment");
+	update = options_string(&global_s_options, OPTC_UPDATE_ENVIRONMENT);
 	if (ctx->cmdclient != NULL)
 		environ_update(update, &ctx->cmdclient->environ, &env);
 
 	/* Create the new session. */
-	idx = -1 - options_get_number(&global_s_options, "base-index");
+	idx = -1 - options_number(&global_s_options, OPTC_BASE_INDEX);
 	s = session_create(
 	    data->newname, cmd, cwd, &env, tiop, idx, sx, sy, &cause);
 	if (s == NULL) {
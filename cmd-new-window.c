@@ -147,14 +147,14 @@ cmd_new_window_exec(struct cmd *self, struct cmd_ctx *ctx)
 
 	cmd = data->cmd;
 	if (cmd == NULL)
-		cmd = options_get_string(&s->options, "default-command");
+		cmd = options_string(&s->options, OPTC_DEFAULT_COMMAND);
 	if (ctx->cmdclient == NULL || ctx->cmdclient->cwd == NULL)
-		cwd = options_get_string(&s->options, "default-path");
+		cwd = options_string(&s->options, OPTC_DEFAULT_PATH);
 	else
 		cwd = ctx->cmdclient->cwd;
 
 	if (idx == -1)
-		idx = -1 - options_get_number(&s->options, "base-index");
+		idx = -1 - options_number(&s->options, OPTC_BASE_INDEX);
 	wl = session_new(s, data->name, cmd, cwd, idx, &cause);
 	if (wl == NULL) {
 		ctx->error(ctx, "create window failed: %s", cause);
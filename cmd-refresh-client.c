@@ -46,6 +46,8 @@ cmd_refresh_client_exec(struct cmd *self, struct cmd_ctx *ctx)
 	if ((c = cmd_find_client(ctx, data->target)) == NULL)
 		return (-1);
 
+	/* Forget what is on the terminal so every cell is redrawn. */
+	tty_frame_invalidate(&c->tty);
 	server_redraw_client(c);
 
 	return (0);
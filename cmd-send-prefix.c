@@ -48,7 +48,7 @@ cmd_send_prefix_exec(struct cmd *self, struct cmd_ctx *ctx)
 	if (cmd_find_pane(ctx, data->target, &s, &wp) == NULL)
 		return (-1);
 
-	keylist = options_get_data(&s->options, "prefix");
+	keylist = options_data(&s->options, OPTC_PREFIX);
 	window_pane_key(wp, ctx->curclient, ARRAY_FIRST(keylist));
 
 	return (0);
@@ -58,7 +58,7 @@ cmd_server_info_exec(unused struct cmd *self, struct cmd_ctx *ctx)
 	struct utsname			 un;
 	struct job			*job;
 	struct grid			*gd;
-	struct grid_line		*gl;
+	const struct grid_line		*gl;
 	u_int		 		 i, j, k;
 	char				 out[80];
 	char				*tim;
@@ -124,28 +124,36 @@ cmd_server_info_exec(unused struct cmd *self, struct cmd_ctx *ctx)
 			TAILQ_FOREACH(wp, &w->panes, entry) {
 				lines = ulines = size = usize = 0;
 				gd = wp->base.grid;
-				for (k = 0; k < gd->hsize + gd->sy; k++) {
-					gl = &gd->linedata[k];
-					if (gl->celldata != NULL) {
+				k = gd->hcomp;
+				for (; k < gd->hsize + gd->sy; k++) {
+					gl = grid_peek_line(gd, k);
+					if (gl->celldata != NULL ||
+					    gl->rundata != NULL) {
 						lines++;
-						size += gl->cellsize *
-						    sizeof *gl->celldata;
+						size += grid_line_size(gl) -
+						    gl->utf8alloc *
+						    sizeof *gl->utf8data;
 					}
 					if (gl->utf8data != NULL) {
 						ulines++;
-						usize += gl->utf8size *
+						usize += gl->utf8alloc *
 						    sizeof *gl->utf8data;
 					}
 				}
 				ctx->print(ctx, "%6u: %s %lu %d %u/%u, %zu "
-				    "bytes; UTF-8 %u/%u, %zu bytes", j,
-				    wp->tty, (u_long) wp->pid, wp->fd, lines,
+				    "bytes; UTF-8 %u/%u, %zu bytes; %lu "
+				    "allocations saved; %u compressed; "
+				    "%lu/%lu lines shared", j, wp->tty,
+				    (u_long) wp->pid, wp->fd, lines,
 				    gd->hsize + gd->sy, size, ulines,
-				    gd->hsize + gd->sy, usize);
+				    gd->hsize + gd->sy, usize, gd->poolsaved,
+				    gd->hcomp, gd->deduphits,
+				    gd->dedupsearched);
 				j++;
 			}
 		}
 	}
+	ctx->print(ctx, "Styles: %u", grid_styles_count);
 	ctx->print(ctx, "%s", "");
 
 	ctx->print(ctx, "Terminals:");
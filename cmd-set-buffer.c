@@ -50,7 +50,7 @@ cmd_set_buffer_exec(struct cmd *self, struct cmd_ctx *ctx)
 
 	if ((s = cmd_find_session(ctx, data->target)) == NULL)
 		return (-1);
-	limit = options_get_number(&s->options, "buffer-limit");
+	limit = options_number(&s->options, OPTC_BUFFER_LIMIT);
 
 	pdata = xstrdup(data->arg);
 	psize = strlen(pdata);
@@ -74,100 +74,163 @@ const char *set_option_bell_action_list[] = {
 };
 
 const struct set_option_entry set_option_table[] = {
-	{ "escape-time", SET_OPTION_NUMBER, 0, INT_MAX, NULL },
-	{ "quiet", SET_OPTION_FLAG, 0, 0, NULL },
-	{ NULL, 0, 0, 0, NULL }
+	{ "escape-time", OPTC_ESCAPE_TIME,
+	  SET_OPTION_NUMBER, 0, INT_MAX, NULL },
+	{ "history-memory-budget", OPTC_HISTORY_MEMORY_BUDGET,
+	  SET_OPTION_NUMBER, 0, INT_MAX, NULL },
+	{ "quiet", OPTC_QUIET, SET_OPTION_FLAG, 0, 0, NULL },
+	{ "render-interval", OPTC_RENDER_INTERVAL,
+	  SET_OPTION_NUMBER, 0, 1000, NULL },
+	{ NULL, 0, 0, 0, 0, NULL }
 };
 
 const struct set_option_entry set_session_option_table[] = {
-	{ "base-index", SET_OPTION_NUMBER, 0, INT_MAX, NULL },
-	{ "bell-action", SET_OPTION_CHOICE, 0, 0, set_option_bell_action_list },
-	{ "buffer-limit", SET_OPTION_NUMBER, 1, INT_MAX, NULL },
-	{ "default-command", SET_OPTION_STRING, 0, 0, NULL },
-	{ "default-path", SET_OPTION_STRING, 0, 0, NULL },
-	{ "default-shell", SET_OPTION_STRING, 0, 0, NULL },
-	{ "default-terminal", SET_OPTION_STRING, 0, 0, NULL },
-	{ "display-panes-colour", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "display-panes-active-colour", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "display-panes-time", SET_OPTION_NUMBER, 1, INT_MAX, NULL },
-	{ "display-time", SET_OPTION_NUMBER, 1, INT_MAX, NULL },
-	{ "history-limit", SET_OPTION_NUMBER, 0, INT_MAX, NULL },
-	{ "lock-after-time", SET_OPTION_NUMBER, 0, INT_MAX, NULL },
-	{ "lock-command", SET_OPTION_STRING, 0, 0, NULL },
-	{ "lock-server", SET_OPTION_FLAG, 0, 0, NULL },
-	{ "message-attr", SET_OPTION_ATTRIBUTES, 0, 0, NULL },
-	{ "message-bg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "message-fg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "message-limit", SET_OPTION_NUMBER, 0, INT_MAX, NULL },
-	{ "mouse-select-pane", SET_OPTION_FLAG, 0, 0, NULL },
-	{ "pane-active-border-bg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "pane-active-border-fg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "pane-border-bg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "pane-border-fg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "prefix", SET_OPTION_KEYS, 0, 0, NULL },
-	{ "repeat-time", SET_OPTION_NUMBER, 0, SHRT_MAX, NULL },
-	{ "set-remain-on-exit", SET_OPTION_FLAG, 0, 0, NULL },
-	{ "set-titles", SET_OPTION_FLAG, 0, 0, NULL },
-	{ "set-titles-string", SET_OPTION_STRING, 0, 0, NULL },
-	{ "status", SET_OPTION_FLAG, 0, 0, NULL },
-	{ "status-attr", SET_OPTION_ATTRIBUTES, 0, 0, NULL },
-	{ "status-bg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "status-fg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "status-interval", SET_OPTION_NUMBER, 0, INT_MAX, NULL },
-	{ "status-justify",
+	{ "base-index", OPTC_BASE_INDEX, SET_OPTION_NUMBER, 0, INT_MAX, NULL },
+	{ "bell-action", OPTC_BELL_ACTION,
+	  SET_OPTION_CHOICE, 0, 0, set_option_bell_action_list },
+	{ "buffer-limit", OPTC_BUFFER_LIMIT,
+	  SET_OPTION_NUMBER, 1, INT_MAX, NULL },
+	{ "default-command", OPTC_DEFAULT_COMMAND,
+	  SET_OPTION_STRING, 0, 0, NULL },
+	{ "default-path", OPTC_DEFAULT_PATH, SET_OPTION_STRING, 0, 0, NULL },
+	{ "default-shell", OPTC_DEFAULT_SHELL, SET_OPTION_STRING, 0, 0, NULL },
+	{ "default-terminal", OPTC_DEFAULT_TERMINAL,
+	  SET_OPTION_STRING, 0, 0, NULL },
+	{ "display-panes-colour", OPTC_DISPLAY_PANES_COLOUR,
+	  SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "display-panes-active-colour", OPTC_DISPLAY_PANES_ACTIVE_COLOUR,
+	  SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "display-panes-time", OPTC_DISPLAY_PANES_TIME,
+	  SET_OPTION_NUMBER, 1, INT_MAX, NULL },
+	{ "display-time", OPTC_DISPLAY_TIME,
+	  SET_OPTION_NUMBER, 1, INT_MAX, NULL },
+	{ "history-limit", OPTC_HISTORY_LIMIT,
+	  SET_OPTION_NUMBER, 0, INT_MAX, NULL },
+	{ "lock-after-time", OPTC_LOCK_AFTER_TIME,
+	  SET_OPTION_NUMBER, 0, INT_MAX, NULL },
+	{ "lock-command", OPTC_LOCK_COMMAND, SET_OPTION_STRING, 0, 0, NULL },
+	{ "lock-server", OPTC_LOCK_SERVER, SET_OPTION_FLAG, 0, 0, NULL },
+	{ "message-attr", OPTC_MESSAGE_ATTR,
+	  SET_OPTION_ATTRIBUTES, 0, 0, NULL },
+	{ "message-bg", OPTC_MESSAGE_BG, SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "message-fg", OPTC_MESSAGE_FG, SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "message-limit", OPTC_MESSAGE_LIMIT,
+	  SET_OPTION_NUMBER, 0, INT_MAX, NULL },
+	{ "mouse-select-pane", OPTC_MOUSE_SELECT_PANE,
+	  SET_OPTION_FLAG, 0, 0, NULL },
+	{ "pane-active-border-bg", OPTC_PANE_ACTIVE_BORDER_BG,
+	  SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "pane-active-border-fg", OPTC_PANE_ACTIVE_BORDER_FG,
+	  SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "pane-border-bg", OPTC_PANE_BORDER_BG,
+	  SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "pane-border-fg", OPTC_PANE_BORDER_FG,
+	  SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "prefix", OPTC_PREFIX, SET_OPTION_KEYS, 0, 0, NULL },
+	{ "repeat-time", OPTC_REPEAT_TIME,
+	  SET_OPTION_NUMBER, 0, SHRT_MAX, NULL },
+	{ "set-remain-on-exit", OPTC_SET_REMAIN_ON_EXIT,
+	  SET_OPTION_FLAG, 0, 0, NULL },
+	{ "set-titles", OPTC_SET_TITLES, SET_OPTION_FLAG, 0, 0, NULL },
+	{ "set-titles-string", OPTC_SET_TITLES_STRING,
+	  SET_OPTION_STRING, 0, 0, NULL },
+	{ "status", OPTC_STATUS, SET_OPTION_FLAG, 0, 0, NULL },
+	{ "status-attr", OPTC_STATUS_ATTR, SET_OPTION_ATTRIBUTES, 0, 0, NULL },
+	{ "status-bg", OPTC_STATUS_BG, SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "status-fg", OPTC_STATUS_FG, SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "status-interval", OPTC_STATUS_INTERVAL,
+	  SET_OPTION_NUMBER, 0, INT_MAX, NULL },
+	{ "status-justify", OPTC_STATUS_JUSTIFY,
 	  SET_OPTION_CHOICE, 0, 0, set_option_status_justify_list },
-	{ "status-keys", SET_OPTION_CHOICE, 0, 0, set_option_status_keys_list },
-	{ "status-left", SET_OPTION_STRING, 0, 0, NULL },
-	{ "status-left-attr", SET_OPTION_ATTRIBUTES, 0, 0, NULL },
-	{ "status-left-bg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "status-left-fg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "status-left-length", SET_OPTION_NUMBER, 0, SHRT_MAX, NULL },
-	{ "status-right", SET_OPTION_STRING, 0, 0, NULL },
-	{ "status-right-attr", SET_OPTION_ATTRIBUTES, 0, 0, NULL },
-	{ "status-right-bg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "status-right-fg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "status-right-length", SET_OPTION_NUMBER, 0, SHRT_MAX, NULL },
-	{ "status-utf8", SET_OPTION_FLAG, 0, 0, NULL },
-	{ "terminal-overrides", SET_OPTION_STRING, 0, 0, NULL },
-	{ "update-environment", SET_OPTION_STRING, 0, 0, NULL },
-	{ "visual-activity", SET_OPTION_FLAG, 0, 0, NULL },
-	{ "visual-bell", SET_OPTION_FLAG, 0, 0, NULL },
-	{ "visual-content", SET_OPTION_FLAG, 0, 0, NULL },
-	{ NULL, 0, 0, 0, NULL }
+	{ "status-keys", OPTC_STATUS_KEYS,
+	  SET_OPTION_CHOICE, 0, 0, set_option_status_keys_list },
+	{ "status-left", OPTC_STATUS_LEFT, SET_OPTION_STRING, 0, 0, NULL },
+	{ "status-left-attr", OPTC_STATUS_LEFT_ATTR,
+	  SET_OPTION_ATTRIBUTES, 0, 0, NULL },
+	{ "status-left-bg", OPTC_STATUS_LEFT_BG,
+	  SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "status-left-fg", OPTC_STATUS_LEFT_FG,
+	  SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "status-left-length", OPTC_STATUS_LEFT_LENGTH,
+	  SET_OPTION_NUMBER, 0, SHRT_MAX, NULL },
+	{ "status-right", OPTC_STATUS_RIGHT, SET_OPTION_STRING, 0, 0, NULL },
+	{ "status-right-attr", OPTC_STATUS_RIGHT_ATTR,
+	  SET_OPTION_ATTRIBUTES, 0, 0, NULL },
+	{ "status-right-bg", OPTC_STATUS_RIGHT_BG,
+	  SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "status-right-fg", OPTC_STATUS_RIGHT_FG,
+	  SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "status-right-length", OPTC_STATUS_RIGHT_LENGTH,
+	  SET_OPTION_NUMBER, 0, SHRT_MAX, NULL },
+	{ "status-utf8", OPTC_STATUS_UTF8, SET_OPTION_FLAG, 0, 0, NULL },
+	{ "terminal-overrides", OPTC_TERMINAL_OVERRIDES,
+	  SET_OPTION_STRING, 0, 0, NULL },
+	{ "update-environment", OPTC_UPDATE_ENVIRONMENT,
+	  SET_OPTION_STRING, 0, 0, NULL },
+	{ "visual-activity", OPTC_VISUAL_ACTIVITY,
+	  SET_OPTION_FLAG, 0, 0, NULL },
+	{ "visual-bell", OPTC_VISUAL_BELL, SET_OPTION_FLAG, 0, 0, NULL },
+	{ "visual-content", OPTC_VISUAL_CONTENT, SET_OPTION_FLAG, 0, 0, NULL },
+	{ NULL, 0, 0, 0, 0, NULL }
 };
 
 const struct set_option_entry set_window_option_table[] = {
-	{ "aggressive-resize", SET_OPTION_FLAG, 0, 0, NULL },
-	{ "alternate-screen", SET_OPTION_FLAG, 0, 0, NULL },
-	{ "automatic-rename", SET_OPTION_FLAG, 0, 0, NULL },
-	{ "clock-mode-colour", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "clock-mode-style",
+	{ "aggressive-resize", OPTC_AGGRESSIVE_RESIZE,
+	  SET_OPTION_FLAG, 0, 0, NULL },
+	{ "alternate-screen", OPTC_ALTERNATE_SCREEN,
+	  SET_OPTION_FLAG, 0, 0, NULL },
+	{ "automatic-rename", OPTC_AUTOMATIC_RENAME,
+	  SET_OPTION_FLAG, 0, 0, NULL },
+	{ "clock-mode-colour", OPTC_CLOCK_MODE_COLOUR,
+	  SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "clock-mode-style", OPTC_CLOCK_MODE_STYLE,
 	  SET_OPTION_CHOICE, 0, 0, set_option_clock_mode_style_list },
-	{ "force-height", SET_OPTION_NUMBER, 0, INT_MAX, NULL },
-	{ "force-width", SET_OPTION_NUMBER, 0, INT_MAX, NULL },
-	{ "main-pane-height", SET_OPTION_NUMBER, 1, INT_MAX, NULL },
-	{ "main-pane-width", SET_OPTION_NUMBER, 1, INT_MAX, NULL },
-	{ "mode-attr", SET_OPTION_ATTRIBUTES, 0, 0, NULL },
-	{ "mode-bg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "mode-fg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "mode-keys", SET_OPTION_CHOICE, 0, 0, set_option_mode_keys_list },
-	{ "mode-mouse", SET_OPTION_FLAG, 0, 0, NULL },
-	{ "monitor-activity", SET_OPTION_FLAG, 0, 0, NULL },
-	{ "monitor-content", SET_OPTION_STRING, 0, 0, NULL },
-	{ "remain-on-exit", SET_OPTION_FLAG, 0, 0, NULL },
-	{ "synchronize-panes", SET_OPTION_FLAG, 0, 0, NULL },
-	{ "utf8", SET_OPTION_FLAG, 0, 0, NULL },
-	{ "window-status-attr", SET_OPTION_ATTRIBUTES, 0, 0, NULL },
-	{ "window-status-bg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "window-status-current-attr", SET_OPTION_ATTRIBUTES, 0, 0, NULL },
-	{ "window-status-current-bg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "window-status-current-fg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "window-status-current-format", SET_OPTION_STRING, 0, 0, NULL },
-	{ "window-status-fg", SET_OPTION_COLOUR, 0, 0, NULL },
-	{ "window-status-format", SET_OPTION_STRING, 0, 0, NULL },
-	{ "word-separators", SET_OPTION_STRING, 0, 0, NULL },
-	{ "xterm-keys", SET_OPTION_FLAG, 0, 0, NULL },
-	{ NULL, 0, 0, 0, NULL }
+	{ "force-height", OPTC_FORCE_HEIGHT,
+	  SET_OPTION_NUMBER, 0, INT_MAX, NULL },
+	{ "force-width", OPTC_FORCE_WIDTH,
+	  SET_OPTION_NUMBER, 0, INT_MAX, NULL },
+	{ "history-compress", OPTC_HISTORY_COMPRESS,
+	  SET_OPTION_NUMBER, 0, INT_MAX, NULL },
+	{ "history-spill", OPTC_HISTORY_SPILL,
+	  SET_OPTION_NUMBER, 0, INT_MAX, NULL },
+	{ "main-pane-height", OPTC_MAIN_PANE_HEIGHT,
+	  SET_OPTION_NUMBER, 1, INT_MAX, NULL },
+	{ "main-pane-width", OPTC_MAIN_PANE_WIDTH,
+	  SET_OPTION_NUMBER, 1, INT_MAX, NULL },
+	{ "mode-attr", OPTC_MODE_ATTR, SET_OPTION_ATTRIBUTES, 0, 0, NULL },
+	{ "mode-bg", OPTC_MODE_BG, SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "mode-fg", OPTC_MODE_FG, SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "mode-keys", OPTC_MODE_KEYS,
+	  SET_OPTION_CHOICE, 0, 0, set_option_mode_keys_list },
+	{ "mode-mouse", OPTC_MODE_MOUSE, SET_OPTION_FLAG, 0, 0, NULL },
+	{ "monitor-activity", OPTC_MONITOR_ACTIVITY,
+	  SET_OPTION_FLAG, 0, 0, NULL },
+	{ "monitor-content", OPTC_MONITOR_CONTENT,
+	  SET_OPTION_STRING, 0, 0, NULL },
+	{ "remain-on-exit", OPTC_REMAIN_ON_EXIT, SET_OPTION_FLAG, 0, 0, NULL },
+	{ "synchronize-panes", OPTC_SYNCHRONIZE_PANES,
+	  SET_OPTION_FLAG, 0, 0, NULL },
+	{ "utf8", OPTC_UTF8, SET_OPTION_FLAG, 0, 0, NULL },
+	{ "window-status-attr", OPTC_WINDOW_STATUS_ATTR,
+	  SET_OPTION_ATTRIBUTES, 0, 0, NULL },
+	{ "window-status-bg", OPTC_WINDOW_STATUS_BG,
+	  SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "window-status-current-attr", OPTC_WINDOW_STATUS_CURRENT_ATTR,
+	  SET_OPTION_ATTRIBUTES, 0, 0, NULL },
+	{ "window-status-current-bg", OPTC_WINDOW_STATUS_CURRENT_BG,
+	  SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "window-status-current-fg", OPTC_WINDOW_STATUS_CURRENT_FG,
+	  SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "window-status-current-format", OPTC_WINDOW_STATUS_CURRENT_FORMAT,
+	  SET_OPTION_STRING, 0, 0, NULL },
+	{ "window-status-fg", OPTC_WINDOW_STATUS_FG,
+	  SET_OPTION_COLOUR, 0, 0, NULL },
+	{ "window-status-format", OPTC_WINDOW_STATUS_FORMAT,
+	  SET_OPTION_STRING, 0, 0, NULL },
+	{ "word-separators", OPTC_WORD_SEPARATORS,
+	  SET_OPTION_STRING, 0, 0, NULL },
+	{ "xterm-keys", OPTC_XTERM_KEYS, SET_OPTION_FLAG, 0, 0, NULL },
+	{ NULL, 0, 0, 0, 0, NULL }
 };
 
 int
@@ -287,10 +350,10 @@ cmd_set_option_exec(struct cmd *self, struct cmd_ctx *ctx)
 	 * or set-titles-string have changed. Persistent jobs are only used by
 	 * the status line at the moment so this works XXX.
 	 */
-	if (strcmp(entry->name, "status-left") == 0 ||
-	    strcmp(entry->name, "status-right") == 0 ||
-	    strcmp(entry->name, "set-titles-string") == 0 ||
-	    strcmp(entry->name, "window-status-format") == 0) {
+	if (entry->code == OPTC_STATUS_LEFT ||
+	    entry->code == OPTC_STATUS_RIGHT ||
+	    entry->code == OPTC_SET_TITLES_STRING ||
+	    entry->code == OPTC_WINDOW_STATUS_FORMAT) {
 		for (i = 0; i < ARRAY_LENGTH(&clients); i++) {
 			c = ARRAY_ITEM(&clients, i);
 			if (c == NULL || c->session == NULL)
@@ -378,7 +441,7 @@ cmd_set_option_string(struct cmd_ctx *ctx, struct options *oo,
 	}
 
 	if (append) {
-		oldvalue = options_get_string(oo, entry->name);
+		oldvalue = options_string(oo, entry->code);
 		xasprintf(&newvalue, "%s%s", oldvalue, value);
 	} else
 		newvalue = value;
@@ -501,7 +564,7 @@ cmd_set_option_flag(struct cmd_ctx *ctx, struct options *oo,
 	int			 flag;
 
 	if (value == NULL || *value == '\0')
-		flag = !options_get_number(oo, entry->name);
+		flag = !options_number(oo, entry->code);
 	else {
 		if ((value[0] == '1' && value[1] == '\0') ||
 		    strcasecmp(value, "on") == 0 ||
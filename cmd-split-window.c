@@ -168,9 +168,9 @@ cmd_split_window_exec(struct cmd *self, struct cmd_ctx *ctx)
 
 	cmd = data->cmd;
 	if (cmd == NULL)
-		cmd = options_get_string(&s->options, "default-command");
+		cmd = options_string(&s->options, OPTC_DEFAULT_COMMAND);
 	if (ctx->cmdclient == NULL || ctx->cmdclient->cwd == NULL)
-		cwd = options_get_string(&s->options, "default-path");
+		cwd = options_string(&s->options, OPTC_DEFAULT_PATH);
 	else
 		cwd = ctx->cmdclient->cwd;
 
@@ -187,9 +187,9 @@ cmd_split_window_exec(struct cmd *self, struct cmd_ctx *ctx)
 		else
 			size = (wp->sx * data->percentage) / 100;
 	}
-	hlimit = options_get_number(&s->options, "history-limit");
+	hlimit = options_number(&s->options, OPTC_HISTORY_LIMIT);
 
-	shell = options_get_string(&s->options, "default-shell");
+	shell = options_string(&s->options, OPTC_DEFAULT_SHELL);
 	if (*shell == '\0' || areshell(shell))
 		shell = _PATH_BSHELL;
 
@@ -0,0 +1,940 @@
+/* $Id$ */
+
+/*
+ * Copyright (c) 2010 Nicholas Marriott <nicm@users.sourceforge.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF MIND, USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING
+ * OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tmux.h"
+
+/*
+ * Compressed history blocks.
+ *
+ * Old history lines are packed GRID_BLOCK_LINES at a time into blocks. Each
+ * line is written out as its flags and size, the cell attributes as runs and
+ * then the text, and the whole block is then compressed with a simple LZ77
+ * scheme. The compressed lines are always the oldest in the history (lines 0
+ * to hcomp - 1) and are no longer present in the grid's ring.
+ *
+ * Reading a compressed line decompresses its block into a small cache of
+ * blocks (most recently used first). Writing to one moves it and every line
+ * after it back into the ring.
+ *
+ * The oldest blocks (the first bspilled) may also be spilled to disk: their
+ * compressed data is appended to an unlinked temporary file and read back
+ * through a mapping of the file. Space in the file is not reused, instead the
+ * live blocks are copied to a new file once most of it is dead.
+ */
+
+/* Maximum number of decompressed blocks kept per grid. */
+#define GRID_BLOCK_CACHE 4
+
+/* Maximum number of blocks to compress at once. */
+#define GRID_BLOCK_BATCH 64
+
+/* Minimum spill file size before dead space is reclaimed. */
+#define GRID_BLOCK_COMPACT (1024 * 1024)
+
+/* Size of each read and write when copying the spill file. */
+#define GRID_BLOCK_CHUNK (64 * 1024)
+
+/* Compression parameters. */
+#define GRID_BLOCK_MINMATCH 4
+#define GRID_BLOCK_MAXOFFSET 65535
+#define GRID_BLOCK_HASHBITS 12
+
+/* Growing output buffer. */
+struct grid_block_buf {
+	u_char	*data;
+	size_t	 size;
+	size_t	 space;
+};
+
+void	grid_block_put(struct grid_block_buf *, const void *, size_t);
+void	grid_block_put_number(struct grid_block_buf *, size_t);
+void	grid_block_put_length(struct grid_block_buf *, size_t);
+size_t	grid_block_get_number(const u_char **, const u_char *);
+size_t	grid_block_get_length(const u_char **, const u_char *);
+
+u_char *grid_block_compress(const u_char *, size_t, size_t *);
+void	grid_block_decompress(const u_char *, size_t, u_char *, size_t);
+
+void	grid_block_line_cell(
+	    const struct grid_line *, u_int, struct grid_cell *);
+void	grid_block_write_line(
+	    struct grid_block_buf *, const struct grid_line *);
+void	grid_block_read_line(
+	    const u_char **, const u_char *, struct grid_line *);
+
+struct grid_block *grid_block_create(struct grid *);
+void	grid_block_free(struct grid *, struct grid_block *);
+void	grid_block_load(struct grid *, struct grid_block *);
+void	grid_block_unload(struct grid *, struct grid_block *);
+const u_char *grid_block_data(struct grid *, struct grid_block *, u_char **);
+
+int	grid_spill_open(void);
+void	grid_spill_close(struct grid *);
+int	grid_spill_read(int, off_t, u_char *, size_t);
+int	grid_spill_write(int, off_t, const u_char *, size_t);
+int	grid_spill_copy(int, off_t, int, off_t, size_t, u_char *);
+int	grid_spill_block(struct grid *, struct grid_block *);
+void	grid_spill_compact(struct grid *);
+
+/* Append to buffer. */
+void
+grid_block_put(struct grid_block_buf *buf, const void *data, size_t size)
+{
+	while (buf->size + size > buf->space) {
+		if (buf->space == 0)
+			buf->space = 1024;
+		buf->data = xrealloc(buf->data, 2, buf->space);
+		buf->space *= 2;
+	}
+	memcpy(buf->data + buf->size, data, size);
+	buf->size += size;
+}
+
+/* Append a number, seven bits at a time. */
+void
+grid_block_put_number(struct grid_block_buf *buf, size_t n)
+{
+	u_char	ch;
+
+	do {
+		ch = n & 0x7f;
+		n >>= 7;
+		if (n != 0)
+			ch |= 0x80;
+		grid_block_put(buf, &ch, 1);
+	} while (n != 0);
+}
+
+/* Append the extra part of a compressed length, as a run of 255s. */
+void
+grid_block_put_length(struct grid_block_buf *buf, size_t n)
+{
+	u_char	ch;
+
+	ch = 255;
+	for (; n >= 255; n -= 255)
+		grid_block_put(buf, &ch, 1);
+	ch = n;
+	grid_block_put(buf, &ch, 1);
+}
+
+/* Read a number. */
+size_t
+grid_block_get_number(const u_char **ptr, const u_char *end)
+{
+	size_t	n;
+	u_int	shift;
+	u_char	ch;
+
+	n = 0;
+	shift = 0;
+	do {
+		if (*ptr == end || shift > 8 * sizeof n)
+			fatalx("bad grid block");
+		ch = *(*ptr)++;
+		n |= (size_t) (ch & 0x7f) << shift;
+		shift += 7;
+	} while (ch & 0x80);
+	return (n);
+}
+
+/* Read the extra part of a compressed length. */
+size_t
+grid_block_get_length(const u_char **ptr, const u_char *end)
+{
+	size_t	n;
+	u_char	ch;
+
+	n = 0;
+	do {
+		if (*ptr == end)
+			fatalx("bad grid block");
+		ch = *(*ptr)++;
+		n += ch;
+	} while (ch == 255);
+	return (n);
+}
+
+/*
+ * Compress a buffer. The output is a series of sequences, each a token byte
+ * with the number of literal bytes in the top four bits and the match length
+ * (less the minimum) in the bottom four, the literal bytes and then a two byte
+ * offset back to the match. Either length may be extended with extra bytes if
+ * it is 15 or more. The last sequence has only literals.
+ */
+u_char *
+grid_block_compress(const u_char *in, size_t insize, size_t *outsize)
+{
+	struct grid_block_buf	 buf;
+	u_int			*table;
+	const u_char		*ip, *anchor, *match, *end, *limit;
+	size_t			 nlit, nmatch, offset;
+	u_int			 hash;
+	u_char			 token, off[2];
+
+	memset(&buf, 0, sizeof buf);
+	table = xcalloc(1 << GRID_BLOCK_HASHBITS, sizeof *table);
+
+	ip = anchor = in;
+	end = in + insize;
+	limit = insize > GRID_BLOCK_MINMATCH ? end - GRID_BLOCK_MINMATCH : in;
+	while (ip < limit) {
+		hash = (ip[0] | ip[1] << 8 | ip[2] << 16 | (u_int) ip[3] << 24);
+		hash = (hash * 2654435761U) >> (32 - GRID_BLOCK_HASHBITS);
+
+		match = in + table[hash];
+		table[hash] = ip - in;
+		if (match >= ip || ip - match > GRID_BLOCK_MAXOFFSET ||
+		    memcmp(match, ip, GRID_BLOCK_MINMATCH) != 0) {
+			ip++;
+			continue;
+		}
+
+		nmatch = GRID_BLOCK_MINMATCH;
+		while (ip + nmatch < end && match[nmatch] == ip[nmatch])
+			nmatch++;
+		nlit = ip - anchor;
+		offset = ip - match;
+
+		token = (nlit < 15 ? nlit : 15) << 4;
+		token |= nmatch - GRID_BLOCK_MINMATCH < 15 ?
+		    nmatch - GRID_BLOCK_MINMATCH : 15;
+		grid_block_put(&buf, &token, 1);
+		if (nlit >= 15)
+			grid_block_put_length(&buf, nlit - 15);
+		grid_block_put(&buf, anchor, nlit);
+
+		off[0] = offset & 0xff;
+		off[1] = offset >> 8;
+		grid_block_put(&buf, off, 2);
+		nmatch -= GRID_BLOCK_MINMATCH;
+		if (nmatch >= 15)
+			grid_block_put_length(&buf, nmatch - 15);
+
+		ip += nmatch + GRID_BLOCK_MINMATCH;
+		anchor = ip;
+	}
+
+	/* And the remaining literals. */
+	nlit = end - anchor;
+	token = (nlit < 15 ? nlit : 15) << 4;
+	grid_block_put(&buf, &token, 1);
+	if (nlit >= 15)
+		grid_block_put_length(&buf, nlit - 15);
+	grid_block_put(&buf, anchor, nlit);
+
+	xfree(table);
+
+	*outsize = buf.size;
+	return (xrealloc(buf.data, 1, buf.size));
+}
+
+/* Decompress a buffer into one of exactly the original size. */
+void
+grid_block_decompress(
+    const u_char *in, size_t insize, u_char *out, size_t outsize)
+{
+	const u_char	*ip, *end;
+	u_char		*op, *match;
+	size_t		 nlit, nmatch, offset;
+	u_char		 token;
+
+	ip = in;
+	end = in + insize;
+	op = out;
+	for (;;) {
+		if (ip == end)
+			fatalx("bad grid block");
+		token = *ip++;
+
+		nlit = token >> 4;
+		if (nlit == 15)
+			nlit += grid_block_get_length(&ip, end);
+		if (nlit > (size_t) (end - ip) || nlit > outsize - (op - out))
+			fatalx("bad grid block");
+		memcpy(op, ip, nlit);
+		ip += nlit;
+		op += nlit;
+
+		if (ip == end)
+			break;
+
+		if (end - ip < 2)
+			fatalx("bad grid block");
+		offset = ip[0] | ip[1] << 8;
+		ip += 2;
+		nmatch = token & 0xf;
+		if (nmatch == 15)
+			nmatch += grid_block_get_length(&ip, end);
+		nmatch += GRID_BLOCK_MINMATCH;
+
+		if (offset == 0 || offset > (size_t) (op - out) ||
+		    nmatch > outsize - (op - out))
+			fatalx("bad grid block");
+
+		/* The match may overlap, so copy a byte at a time. */
+		match = op - offset;
+		while (nmatch-- != 0)
+			*op++ = *match++;
+	}
+	if (op != out + outsize)
+		fatalx("bad grid block");
+}
+
+/* Get a cell from a line, which may be packed. */
+void
+grid_block_line_cell(
+    const struct grid_line *gl, u_int px, struct grid_cell *gc)
+{
+	if (gl->rundata != NULL)
+		grid_packed_cell(gl, px, gc);
+	else
+		memcpy(gc, &gl->celldata[px], sizeof *gc);
+}
+
+/* Write a line into a block. */
+void
+grid_block_write_line(struct grid_block_buf *buf, const struct grid_line *gl)
+{
+	struct grid_cell	 gc, last;
+	const struct grid_utf8	*gu;
+	u_int			 xx, run;
+	u_char			 size;
+
+	grid_block_put_number(buf, gl->flags);
+	grid_block_put_number(buf, gl->cellsize);
+	if (gl->cellsize == 0)
+		return;
+
+	/* Attributes as runs of identical cells. */
+	grid_block_line_cell(gl, 0, &last);
+	memcpy(&gc, &last, sizeof gc);
+	run = 1;
+	for (xx = 1; xx <= gl->cellsize; xx++) {
+		if (xx != gl->cellsize) {
+			grid_block_line_cell(gl, xx, &gc);
+			if (grid_style_key(&gc) == grid_style_key(&last)) {
+				run++;
+				continue;
+			}
+		}
+		grid_block_put_number(buf, run);
+		grid_block_put(buf, &last, offsetof(struct grid_cell, data));
+		memcpy(&last, &gc, sizeof last);
+		run = 1;
+	}
+
+	/* Then the text. */
+	for (xx = 0; xx < gl->cellsize; xx++) {
+		grid_block_line_cell(gl, xx, &gc);
+		grid_block_put(buf, &gc.data, 1);
+	}
+
+	/* And the UTF-8 data for UTF-8 cells. */
+	for (xx = 0; xx < gl->cellsize; xx++) {
+		grid_block_line_cell(gl, xx, &gc);
+		if (!(gc.flags & GRID_FLAG_UTF8))
+			continue;
+		if ((gu = grid_line_utf8(gl, xx)) == NULL) {
+			size = 0;
+			grid_block_put(buf, &size, 1);
+			grid_block_put(buf, &size, 1);
+			continue;
+		}
+		size = grid_utf8_size(gu);
+		grid_block_put(buf, &gu->width, 1);
+		grid_block_put(buf, &size, 1);
+		grid_block_put(buf, gu->data, size);
+	}
+}
+
+/*
+ * Read a line from a block. The line is read back into cells and then packed
+ * again if possible.
+ */
+void
+grid_block_read_line(
+    const u_char **ptr, const u_char *end, struct grid_line *gl)
+{
+	struct grid_utf8	*gu;
+	u_int			 xx, n, i;
+	u_char			 size;
+
+	memset(gl, 0, sizeof *gl);
+	gl->flags = grid_block_get_number(ptr, end);
+	gl->cellsize = grid_block_get_number(ptr, end);
+	if (gl->cellsize == 0)
+		return;
+	gl->celldata = xcalloc(gl->cellsize, sizeof *gl->celldata);
+	gl->cellalloc = gl->cellsize;
+
+	for (xx = 0; xx < gl->cellsize; xx += n) {
+		n = grid_block_get_number(ptr, end);
+		if (n == 0 || n > gl->cellsize - xx ||
+		    (size_t) (end - *ptr) < offsetof(struct grid_cell, data))
+			fatalx("bad grid block");
+		for (i = 0; i < n; i++) {
+			memcpy(&gl->celldata[xx + i],
+			    *ptr, offsetof(struct grid_cell, data));
+		}
+		*ptr += offsetof(struct grid_cell, data);
+	}
+
+	if ((size_t) (end - *ptr) < gl->cellsize)
+		fatalx("bad grid block");
+	for (xx = 0; xx < gl->cellsize; xx++)
+		gl->celldata[xx].data = *(*ptr)++;
+
+	for (xx = 0; xx < gl->cellsize; xx++) {
+		if (!(gl->celldata[xx].flags & GRID_FLAG_UTF8))
+			continue;
+		gu = grid_line_add_utf8(gl, xx);
+
+		if (end - *ptr < 2)
+			fatalx("bad grid block");
+		gu->width = *(*ptr)++;
+		size = *(*ptr)++;
+		if (size > sizeof gu->data || end - *ptr < size)
+			fatalx("bad grid block");
+		memcpy(gu->data, *ptr, size);
+		if (size != sizeof gu->data)
+			gu->data[size] = 0xff;
+		*ptr += size;
+	}
+	if (gl->utf8alloc > gl->utf8size) {
+		gl->utf8data = xrealloc(
+		    gl->utf8data, gl->utf8size, sizeof *gl->utf8data);
+		gl->utf8alloc = gl->utf8size;
+	}
+
+	if (grid_pack_line(gl) == 0) {
+		xfree(gl->celldata);
+		gl->celldata = NULL;
+		gl->cellalloc = 0;
+	}
+}
+
+/* Compress the oldest lines in the ring into a new block. */
+struct grid_block *
+grid_block_create(struct grid *gd)
+{
+	struct grid_block	*gb;
+	struct grid_block_buf	 buf;
+	struct grid_line	*gl;
+	u_int			 yy;
+
+	gb = xcalloc(1, sizeof *gb);
+
+	memset(&buf, 0, sizeof buf);
+	for (yy = 0; yy < GRID_BLOCK_LINES; yy++) {
+		gl = grid_ring_line(gd, gd->hcomp + yy);
+		grid_block_write_line(&buf, gl);
+
+		gb->linesize += grid_line_size(gl);
+		gd->hbytes -= grid_history_line_size(gl);
+		grid_free_line(gd, gl);
+	}
+	gb->rawsize = buf.size;
+	gb->data = grid_block_compress(buf.data, buf.size, &gb->size);
+	xfree(buf.data);
+	gd->hbytes += gb->size;
+
+	return (gb);
+}
+
+/* Free a block. */
+void
+grid_block_free(struct grid *gd, struct grid_block *gb)
+{
+	if (gb->linedata != NULL)
+		grid_block_unload(gd, gb);
+
+	if (gb->data != NULL) {
+		gd->hbytes -= gb->size;
+		xfree(gb->data);
+	} else {
+		gd->spilllive -= gb->size;
+		if (gd->spilllive == 0)
+			grid_spill_close(gd);
+	}
+	xfree(gb);
+}
+
+/*
+ * Get the compressed data for a block, from memory or the spill file. The file
+ * is read through a mapping; if it cannot be mapped the block is read into a
+ * buffer returned in buf for the caller to free. Returns NULL if the block
+ * cannot be read at all.
+ */
+const u_char *
+grid_block_data(struct grid *gd, struct grid_block *gb, u_char **buf)
+{
+	size_t	size;
+
+	*buf = NULL;
+	if (gb->data != NULL)
+		return (gb->data);
+
+	if (gb->offset + gb->size > gd->spillmapsize) {
+		if (gd->spillmap != NULL)
+			munmap(gd->spillmap, gd->spillmapsize);
+		size = gd->spillsize;
+		gd->spillmap = mmap(
+		    NULL, size, PROT_READ, MAP_SHARED, gd->spillfd, 0);
+		if (gd->spillmap == MAP_FAILED) {
+			log_debug("mmap failed: %s", strerror(errno));
+			gd->spillmap = NULL;
+			gd->spillmapsize = 0;
+		} else
+			gd->spillmapsize = size;
+	}
+	if (gd->spillmap != NULL)
+		return (gd->spillmap + gb->offset);
+
+	*buf = xmalloc(gb->size);
+	if (grid_spill_read(gd->spillfd, gb->offset, *buf, gb->size) != 0) {
+		xfree(*buf);
+		*buf = NULL;
+		return (NULL);
+	}
+	return (*buf);
+}
+
+/* Decompress a block into the cache. */
+void
+grid_block_load(struct grid *gd, struct grid_block *gb)
+{
+	u_char		*raw, *buf;
+	const u_char	*data, *ptr, *end;
+	u_int		 yy;
+
+	if (gb->linedata != NULL) {
+		TAILQ_REMOVE(&gd->bcache, gb, entry);
+		TAILQ_INSERT_HEAD(&gd->bcache, gb, entry);
+		return;
+	}
+
+	if (gd->bcached == GRID_BLOCK_CACHE)
+		grid_block_unload(gd, TAILQ_LAST(&gd->bcache, grid_blocks));
+
+	/*
+	 * If the block cannot be read back from the spill file, its lines are
+	 * lost and left empty rather than giving up on the whole server.
+	 */
+	gb->linedata = xcalloc(GRID_BLOCK_LINES, sizeof *gb->linedata);
+	if ((data = grid_block_data(gd, gb, &buf)) != NULL) {
+		raw = xmalloc(gb->rawsize);
+		grid_block_decompress(data, gb->size, raw, gb->rawsize);
+		if (buf != NULL)
+			xfree(buf);
+
+		ptr = raw;
+		end = raw + gb->rawsize;
+		for (yy = 0; yy < GRID_BLOCK_LINES; yy++)
+			grid_block_read_line(&ptr, end, &gb->linedata[yy]);
+		if (ptr != end)
+			fatalx("bad grid block");
+		xfree(raw);
+	}
+
+	TAILQ_INSERT_HEAD(&gd->bcache, gb, entry);
+	gd->bcached++;
+}
+
+/* Drop a block's decompressed lines. */
+void
+grid_block_unload(struct grid *gd, struct grid_block *gb)
+{
+	struct grid_line	*gl;
+	u_int			 yy;
+
+	for (yy = 0; yy < GRID_BLOCK_LINES; yy++) {
+		gl = &gb->linedata[yy];
+		if (gl->celldata != NULL)
+			xfree(gl->celldata);
+		if (gl->rundata != NULL)
+			grid_free_runs(gl);
+		if (gl->utf8data != NULL)
+			xfree(gl->utf8data);
+	}
+	xfree(gb->linedata);
+	gb->linedata = NULL;
+
+	TAILQ_REMOVE(&gd->bcache, gb, entry);
+	gd->bcached--;
+}
+
+/*
+ * Compress history lines more than depth lines back. A limited number of
+ * blocks is done each time so this never takes too long.
+ */
+void
+grid_compress_history(struct grid *gd, u_int depth)
+{
+	u_int	n;
+
+	if (depth == 0)
+		return;
+
+	for (n = 0; n < GRID_BLOCK_BATCH; n++) {
+		if (gd->hsize < depth ||
+		    gd->hcomp + GRID_BLOCK_LINES > gd->hsize - depth)
+			break;
+
+		ARRAY_ADD(&gd->blocks, grid_block_create(gd));
+
+		/* The lines are now empty, so move the start of the ring. */
+		gd->loffset += GRID_BLOCK_LINES;
+		if (gd->loffset >= gd->lsize)
+			gd->loffset -= gd->lsize;
+		gd->hcomp += GRID_BLOCK_LINES;
+	}
+}
+
+/* Get a compressed line for reading. */
+const struct grid_line *
+grid_block_peek_line(struct grid *gd, u_int py)
+{
+	struct grid_block	*gb;
+
+	py += gd->bskip;
+	gb = ARRAY_ITEM(&gd->blocks, py / GRID_BLOCK_LINES);
+	grid_block_load(gd, gb);
+	return (&gb->linedata[py % GRID_BLOCK_LINES]);
+}
+
+/* Drop the oldest compressed line. */
+void
+grid_block_drop_line(struct grid *gd)
+{
+	struct grid_block	*gb;
+
+	gd->hcomp--;
+	if (++gd->bskip != GRID_BLOCK_LINES)
+		return;
+
+	gb = ARRAY_FIRST(&gd->blocks);
+	ARRAY_REMOVE(&gd->blocks, 0);
+	grid_block_free(gd, gb);
+	gd->bskip = 0;
+
+	if (gd->bspilled != 0)
+		gd->bspilled--;
+}
+
+/* Free all the blocks, dropping the compressed lines from the history. */
+void
+grid_block_free_all(struct grid *gd)
+{
+	u_int	i;
+
+	for (i = 0; i < ARRAY_LENGTH(&gd->blocks); i++)
+		grid_block_free(gd, ARRAY_ITEM(&gd->blocks, i));
+	ARRAY_FREE(&gd->blocks);
+	gd->bspilled = 0;
+	grid_spill_close(gd);
+
+	gd->hsize -= gd->hcomp;
+	gd->hcomp = 0;
+	gd->bskip = 0;
+}
+
+/*
+ * Move compressed lines from py onwards back into the ring, so they may be
+ * modified.
+ */
+void
+grid_block_thaw(struct grid *gd, u_int py)
+{
+	struct grid_block	*gb;
+	struct grid_line	*gl;
+	u_int			 yy, first;
+
+	while (gd->hcomp > py) {
+		gb = ARRAY_LAST(&gd->blocks);
+		grid_block_load(gd, gb);
+
+		/* The first block may have had lines dropped from the start. */
+		first = 0;
+		if (ARRAY_LENGTH(&gd->blocks) == 1)
+			first = gd->bskip;
+
+		grid_reserve_lines(
+		    gd, gd->hsize + gd->sy + GRID_BLOCK_LINES - first);
+		for (yy = GRID_BLOCK_LINES; yy > first; yy--) {
+			if (gd->loffset == 0)
+				gd->loffset = gd->lsize;
+			gd->loffset--;
+			gd->hcomp--;
+
+			gl = grid_ring_line(gd, gd->hcomp);
+			memcpy(gl, &gb->linedata[yy - 1], sizeof *gl);
+			memset(&gb->linedata[yy - 1], 0, sizeof *gl);
+			if (gd->hcomp < gd->hsize)
+				gd->hbytes += grid_history_line_size(gl);
+		}
+
+		ARRAY_TRUNC(&gd->blocks, 1);
+		grid_block_free(gd, gb);
+		if (ARRAY_EMPTY(&gd->blocks))
+			gd->bskip = 0;
+		if (gd->bspilled > ARRAY_LENGTH(&gd->blocks))
+			gd->bspilled = ARRAY_LENGTH(&gd->blocks);
+	}
+}
+
+/*
+ * Get the size of the compressed lines in memory and on disk and their size
+ * before compression.
+ */
+void
+grid_block_sizes(
+    struct grid *gd, size_t *size, size_t *spilled, size_t *linesize)
+{
+	struct grid_block	*gb;
+	u_int			 i;
+
+	*size = *spilled = *linesize = 0;
+	for (i = 0; i < ARRAY_LENGTH(&gd->blocks); i++) {
+		gb = ARRAY_ITEM(&gd->blocks, i);
+		if (gb->data != NULL)
+			*size += gb->size;
+		else
+			*spilled += gb->size;
+		*linesize += gb->linesize;
+	}
+}
+
+/*
+ * Spill compressed history more than depth lines back to disk. Like
+ * compression, only a limited number of blocks is done at once.
+ */
+void
+grid_spill_history(struct grid *gd, u_int depth)
+{
+	struct grid_block	*gb;
+	u_int			 n, last;
+
+	if (depth == 0)
+		return;
+
+	if (gd->spillsize >= GRID_BLOCK_COMPACT &&
+	    (size_t) gd->spillsize > gd->spilllive * 2)
+		grid_spill_compact(gd);
+
+	for (n = 0; n < GRID_BLOCK_BATCH; n++) {
+		if (gd->bspilled == ARRAY_LENGTH(&gd->blocks))
+			break;
+
+		/* Line after the end of the block. */
+		last = (gd->bspilled + 1) * GRID_BLOCK_LINES - gd->bskip;
+		if (last > gd->hsize || gd->hsize - last < depth)
+			break;
+
+		gb = ARRAY_ITEM(&gd->blocks, gd->bspilled);
+		if (grid_spill_block(gd, gb) != 0)
+			break;
+		gd->bspilled++;
+	}
+}
+
+/*
+ * Create a spill file and return its fd. It is unlinked at once so only the fd
+ * remains.
+ */
+int
+grid_spill_open(void)
+{
+	char	path[MAXPATHLEN];
+	int	fd;
+
+	xsnprintf(path, sizeof path, "%s/tmux-history.XXXXXXXX", _PATH_TMP);
+	if ((fd = mkstemp(path)) == -1) {
+		log_debug("%s: %s", path, strerror(errno));
+		return (-1);
+	}
+	unlink(path);
+	if (fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)
+		fatal("fcntl failed");
+
+	return (fd);
+}
+
+/* Close and forget the spill file once nothing is left in it. */
+void
+grid_spill_close(struct grid *gd)
+{
+	if (gd->spillmap != NULL)
+		munmap(gd->spillmap, gd->spillmapsize);
+	gd->spillmap = NULL;
+	gd->spillmapsize = 0;
+
+	if (gd->spillfd != -1)
+		close(gd->spillfd);
+	gd->spillfd = -1;
+	gd->spillsize = 0;
+	gd->spilllive = 0;
+}
+
+/* Append a block's data to the spill file and free it from memory. */
+int
+grid_spill_block(struct grid *gd, struct grid_block *gb)
+{
+	if (gd->spillfd == -1 && (gd->spillfd = grid_spill_open()) == -1)
+		return (-1);
+
+	if (grid_spill_write(
+	    gd->spillfd, gd->spillsize, gb->data, gb->size) != 0)
+		return (-1);
+
+	gb->offset = gd->spillsize;
+	gd->spillsize += gb->size;
+	gd->spilllive += gb->size;
+
+	gd->hbytes -= gb->size;
+	xfree(gb->data);
+	gb->data = NULL;
+	return (0);
+}
+
+/* Read from a spill file. */
+int
+grid_spill_read(int fd, off_t offset, u_char *buf, size_t size)
+{
+	size_t	done;
+	ssize_t	n;
+
+	for (done = 0; done < size; done += n) {
+		n = pread(fd, buf + done, size - done, offset + done);
+		if (n == -1 && errno == EINTR) {
+			n = 0;
+			continue;
+		}
+		if (n <= 0) {
+			log_debug("spill read failed: %s",
+			    n == 0 ? "short file" : strerror(errno));
+			return (-1);
+		}
+	}
+	return (0);
+}
+
+/* Write to a spill file. */
+int
+grid_spill_write(int fd, off_t offset, const u_char *buf, size_t size)
+{
+	size_t	done;
+	ssize_t	n;
+
+	for (done = 0; done < size; done += n) {
+		n = pwrite(fd, buf + done, size - done, offset + done);
+		if (n == -1 && errno == EINTR) {
+			n = 0;
+			continue;
+		}
+		if (n <= 0) {
+			log_debug("spill failed: %s", strerror(errno));
+			return (-1);
+		}
+	}
+	return (0);
+}
+
+/* Copy between spill files through buf, GRID_BLOCK_CHUNK bytes at a time. */
+int
+grid_spill_copy(
+    int fromfd, off_t from, int tofd, off_t to, size_t size, u_char *buf)
+{
+	size_t	done, n;
+
+	for (done = 0; done < size; done += n) {
+		n = size - done;
+		if (n > GRID_BLOCK_CHUNK)
+			n = GRID_BLOCK_CHUNK;
+		if (grid_spill_read(fromfd, from + done, buf, n) != 0)
+			return (-1);
+		if (grid_spill_write(tofd, to + done, buf, n) != 0)
+			return (-1);
+	}
+	return (0);
+}
+
+/*
+ * Reclaim the space in the spill file used by dropped blocks: copy the blocks
+ * still in it to a new file, a chunk at a time so nothing large is brought back
+ * into memory, and switch to that. If the copy fails the old file is kept.
+ */
+void
+grid_spill_compact(struct grid *gd)
+{
+	struct grid_block	*gb;
+	u_char			*buf;
+	off_t			 from, offset;
+	size_t			 size;
+	u_int			 i, j;
+	int			 fd;
+
+	if ((fd = grid_spill_open()) == -1)
+		return;
+	buf = xmalloc(GRID_BLOCK_CHUNK);
+
+	offset = 0;
+	for (i = 0; i < gd->bspilled; i = j) {
+		/* Blocks next to each other in the file are copied together. */
+		from = ARRAY_ITEM(&gd->blocks, i)->offset;
+		size = 0;
+		for (j = i; j < gd->bspilled; j++) {
+			gb = ARRAY_ITEM(&gd->blocks, j);
+			if (gb->offset != from + (off_t) size)
+				break;
+			size += gb->size;
+		}
+
+		if (grid_spill_copy(
+		    gd->spillfd, from, fd, offset, size, buf) != 0) {
+			xfree(buf);
+			close(fd);
+			return;
+		}
+		offset += size;
+	}
+	xfree(buf);
+
+	offset = 0;
+	for (i = 0; i < gd->bspilled; i++) {
+		gb = ARRAY_ITEM(&gd->blocks, i);
+		gb->offset = offset;
+		offset += gb->size;
+	}
+
+	grid_spill_close(gd);
+	gd->spillfd = fd;
+	gd->spillsize = offset;
+	gd->spilllive = offset;
+}
@@ -0,0 +1,163 @@
+/* $Id$ */
+
+/*
+ * Copyright (c) 2010 Nicholas Marriott <nicm@users.sourceforge.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF MIND, USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING
+ * OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sys/types.h>
+
+#include <string.h>
+
+#include "tmux.h"
+
+/*
+ * Cell style palette.
+ *
+ * Each combination of attributes, flags and colours in use is kept once in a
+ * table shared by all grids, and packed lines refer to it by its index rather
+ * than holding the style for each run. Styles are found by a hash of their key
+ * and reference counted; once unused their slot is put on a free list to be
+ * used again. Style 0 is the default style and is never freed.
+ *
+ * There is room for GRID_STYLE_NONE styles. If they are all in use, adding a
+ * style fails and the caller must keep the cells as they are.
+ */
+
+/* Number of hash chains. */
+#define GRID_STYLE_HASHSIZE 1024
+
+struct grid_style *grid_styles;
+u_int	grid_styles_size;	/* slots allocated */
+u_int	grid_styles_next;	/* first slot never used */
+u_int	grid_styles_count;	/* styles in use */
+u_short	grid_styles_free;	/* first unused slot, by next */
+u_short	grid_styles_hash[GRID_STYLE_HASHSIZE];
+
+void	grid_style_init(void);
+u_int	grid_style_hash(u_int);
+
+/* Set up the table with the default style. */
+void
+grid_style_init(void)
+{
+	u_int	i;
+
+	for (i = 0; i < GRID_STYLE_HASHSIZE; i++)
+		grid_styles_hash[i] = GRID_STYLE_NONE;
+	grid_styles_free = GRID_STYLE_NONE;
+
+	grid_styles_size = 64;
+	grid_styles = xcalloc(grid_styles_size, sizeof *grid_styles);
+
+	if (grid_style_add(&grid_default_cell) != GRID_STYLE_DEFAULT)
+		fatalx("bad default style");
+}
+
+/* Get the hash chain for a style key. */
+u_int
+grid_style_hash(u_int key)
+{
+	return ((key * 2654435761U) >> 22);
+}
+
+/*
+ * Find or add a style for the attributes, flags and colours of a cell and take
+ * a reference to it. Returns GRID_STYLE_NONE if the table is full.
+ */
+u_short
+grid_style_add(const struct grid_cell *gc)
+{
+	struct grid_style	*gs;
+	u_int			 key, hash;
+	u_short			 id;
+
+	if (grid_styles == NULL)
+		grid_style_init();
+
+	key = grid_style_key(gc);
+	hash = grid_style_hash(key);
+	for (id = grid_styles_hash[hash]; id != GRID_STYLE_NONE; id = gs->next) {
+		gs = &grid_styles[id];
+		if (grid_style_key(gs) == key) {
+			gs->references++;
+			return (id);
+		}
+	}
+
+	if (grid_styles_free != GRID_STYLE_NONE) {
+		id = grid_styles_free;
+		grid_styles_free = grid_styles[id].next;
+	} else {
+		if (grid_styles_next == GRID_STYLE_NONE)
+			return (GRID_STYLE_NONE);
+		if (grid_styles_next == grid_styles_size) {
+			grid_styles = xrealloc(grid_styles,
+			    grid_styles_size * 2, sizeof *grid_styles);
+			grid_styles_size *= 2;
+		}
+		id = grid_styles_next++;
+	}
+	grid_styles_count++;
+
+	gs = &grid_styles[id];
+	gs->attr = gc->attr;
+	gs->flags = gc->flags;
+	gs->fg = gc->fg;
+	gs->bg = gc->bg;
+	gs->references = 1;
+
+	gs->next = grid_styles_hash[hash];
+	grid_styles_hash[hash] = id;
+	return (id);
+}
+
+/* Take another reference to a style. */
+void
+grid_style_ref(u_short id)
+{
+	grid_styles[id].references++;
+}
+
+/* Drop a reference to a style, freeing it if it was the last. */
+void
+grid_style_free(u_short id)
+{
+	struct grid_style	*gs = &grid_styles[id];
+	u_short			*idp;
+
+	if (id == GRID_STYLE_DEFAULT || --gs->references != 0)
+		return;
+
+	idp = &grid_styles_hash[grid_style_hash(grid_style_key(gs))];
+	while (*idp != id)
+		idp = &grid_styles[*idp].next;
+	*idp = gs->next;
+
+	gs->next = grid_styles_free;
+	grid_styles_free = id;
+	grid_styles_count--;
+}
+
+/* Set the attributes, flags and colours of a cell from a style. */
+void
+grid_style_set(u_short id, struct grid_cell *gc)
+{
+	const struct grid_style	*gs = &grid_styles[id];
+
+	gc->attr = gs->attr;
+	gc->flags = gs->flags;
+	gc->fg = gs->fg;
+	gc->bg = gs->bg;
+}
@@ -52,6 +52,15 @@ grid_view_set_cell(
 	grid_set_cell(gd, grid_view_x(gd, px), grid_view_y(gd, py), gc);
 }
 
+/* Set a run of cells. */
+void
+grid_view_set_cells(struct grid *gd, u_int px, u_int py,
+    const struct grid_cell *gc, const u_char *buf, u_int nx)
+{
+	grid_set_cells(
+	    gd, grid_view_x(gd, px), grid_view_y(gd, py), gc, buf, nx);
+}
+
 /* Get UTF-8 for reading. */
 const struct grid_utf8 *
 grid_view_peek_utf8(struct grid *gd, u_int px, u_int py)
@@ -86,25 +95,36 @@ grid_view_clear(struct grid *gd, u_int px, u_int py, u_int nx, u_int ny)
 	grid_clear(gd, px, py, nx, ny);
 }
 
-/* Scroll region up. */
+/* Scroll region up by ny lines. */
 void
-grid_view_scroll_region_up(struct grid *gd, u_int rupper, u_int rlower)
+grid_view_scroll_region_up(
+    struct grid *gd, u_int rupper, u_int rlower, u_int ny)
 {
-	GRID_DEBUG(gd, "rupper=%u, rlower=%u", rupper, rlower);
+	u_int	n;
+
+	GRID_DEBUG(gd, "rupper=%u, rlower=%u, ny=%u", rupper, rlower, ny);
 
 	if (gd->flags & GRID_HISTORY) {
-		grid_collect_history(gd);
-		if (rupper == 0 && rlower == gd->sy - 1)
-			grid_scroll_history(gd);
-		else {
-			rupper = grid_view_y(gd, rupper);
-			rlower = grid_view_y(gd, rlower);
-			grid_scroll_history_region(gd, rupper, rlower);
+		if (rupper == 0 && rlower == gd->sy - 1) {
+			grid_scroll_history(gd, ny);
+			return;
+		}
+
+		/* No more than the region at once; the history moves it. */
+		for (; ny > 0; ny -= n) {
+			n = rlower - rupper + 1;
+			if (n > ny)
+				n = ny;
+			grid_scroll_history_region(gd, grid_view_y(gd, rupper),
+			    grid_view_y(gd, rlower), n);
 		}
 	} else {
+		if (ny > rlower - rupper + 1)
+			ny = rlower - rupper + 1;
 		rupper = grid_view_y(gd, rupper);
 		rlower = grid_view_y(gd, rlower);
-		grid_move_lines(gd, rupper, rupper + 1, rlower - rupper);
+		grid_clear_lines(gd, rupper, ny);
+		grid_move_lines(gd, rupper, rupper + ny, rlower - rupper + 1 - ny);
 	}
 }
 
@@ -32,23 +32,75 @@
  * (hsize - 1); from hsize to hsize + (sy - 1) is the viewable data. All
  * functions in this file work on absolute coordinates, grid-view.c has
  * functions which work on the screen data.
+ *
+ * The lines are kept in a ring (linedata) of lsize entries with line 0 at index
+ * loffset. Moving a line into the history and dropping the oldest line are done
+ * by moving the ends of the ring, so neither has to reallocate or move the
+ * other lines. Entries in the ring which are not in use are always zeroed.
+ *
+ * Line storage is allocated a screen width at a time rather than a cell at a
+ * time as the line is filled in, and the storage of cleared lines is kept on a
+ * free list (up to a screen's worth) to be used for the next new line.
+ *
+ * UTF-8 data is only needed for cells with GRID_FLAG_UTF8, so each line has a
+ * table (utf8data) with an entry for each such cell, sorted by column.
+ *
+ * When a line is moved into the history, it is packed if that saves memory:
+ * the styles are kept as runs of identical cells, usually only one or two per
+ * line, followed by the characters (rundata). Each run refers to its style in
+ * the palette in grid-style.c. Cells are built from the
+ * packed line as they are read, and getting a packed line for writing unpacks
+ * it. Lines which are not packed are trimmed to their real size.
+ *
+ * The oldest hcomp lines of history may be compressed into blocks and removed
+ * from the ring, see grid-block.c.
+ *
+ * Copying lines between grids (such as for the alternate screen) shares their
+ * storage rather than copying it. Shared lines have a reference count which is
+ * dropped when the line is freed, and a line is given its own copy of the
+ * storage the first time it is written to.
+ *
+ * Lines moved into the history are also looked up in a small table of recent
+ * history lines by hash, and share storage with an identical line if found.
+ * This catches repeated lines such as separators and redrawn progress bars.
  */
 
 /* Default grid cell data. */
 const struct grid_cell grid_default_cell = { 0, 0, 8, 8, ' ' };
 
 #define grid_put_cell(gd, px, py, gc) do {			\
-	memcpy(&gd->linedata[py].celldata[px], 			\
-	    gc, sizeof gd->linedata[py].celldata[px]);		\
-} while (0)
-#define grid_put_utf8(gd, px, py, gc) do {			\
-	memcpy(&gd->linedata[py].utf8data[px], 			\
-	    gc, sizeof gd->linedata[py].utf8data[px]);		\
+	memcpy(&grid_get_line(gd, py)->celldata[px], 		\
+	    gc, sizeof (struct grid_cell));			\
 } while (0)
 
 int	grid_check_x(struct grid *, u_int);
 int	grid_check_y(struct grid *, u_int);
 
+void	grid_check_pool(struct grid *);
+void	grid_reserve_cells(struct grid *, struct grid_line *, u_int);
+u_int	grid_search_utf8(const struct grid_line *, u_int);
+void	grid_sort_utf8(struct grid_line *);
+void	grid_trim_line(struct grid *, struct grid_line *);
+void	grid_unpack_line(struct grid *, struct grid_line *);
+uint32_t grid_hash_line(const struct grid_line *);
+int	grid_equal_lines(const struct grid_line *, const struct grid_line *);
+void	grid_dedup_line(struct grid *, struct grid_line *);
+
+/*
+ * Coordinates from outside the grid code are checked by grid_check_x and
+ * grid_check_y. The screen update paths use the unchecked accessors instead,
+ * as their coordinates come from the cursor or screen size; with DEBUG these
+ * are checked as well, so a bad coordinate is still fatal.
+ */
+#ifdef DEBUG
+#define grid_assert_xy(gd, px, py) do {				\
+	grid_check_x(gd, px);					\
+	grid_check_y(gd, py);					\
+} while (0)
+#else
+#define grid_assert_xy(gd, px, py)
+#endif
+
 #ifdef DEBUG
 int
 grid_check_x(struct grid *gd, u_int px)
@@ -101,8 +153,33 @@ grid_create(u_int sx, u_int sy, u_int hlimit)
 
 	gd->hsize = 0;
 	gd->hlimit = hlimit;
+	gd->hbytes = 0;
 
 	gd->linedata = xcalloc(gd->sy, sizeof *gd->linedata);
+	gd->lsize = gd->sy;
+	gd->loffset = 0;
+
+	gd->poolsx = gd->sx;
+	ARRAY_INIT(&gd->cellpool);
+	gd->poolsaved = 0;
+
+	gd->hdropped = 0;
+	gd->dedup = NULL;
+	gd->dedupsearched = 0;
+	gd->deduphits = 0;
+
+	gd->hcomp = 0;
+	gd->bskip = 0;
+	ARRAY_INIT(&gd->blocks);
+	TAILQ_INIT(&gd->bcache);
+	gd->bcached = 0;
+
+	gd->bspilled = 0;
+	gd->spillfd = -1;
+	gd->spillmap = NULL;
+	gd->spillmapsize = 0;
+	gd->spillsize = 0;
+	gd->spilllive = 0;
 
 	return (gd);
 }
@@ -111,16 +188,18 @@ grid_create(u_int sx, u_int sy, u_int hlimit)
 void
 grid_destroy(struct grid *gd)
 {
-	struct grid_line	*gl;
-	u_int			 yy;
+	u_int	yy;
 
-	for (yy = 0; yy < gd->hsize + gd->sy; yy++) {
-		gl = &gd->linedata[yy];
-		if (gl->celldata != NULL)
-			xfree(gl->celldata);
-		if (gl->utf8data != NULL)
-			xfree(gl->utf8data);
-	}
+	for (yy = gd->hcomp; yy < gd->hsize + gd->sy; yy++)
+		grid_free_line(gd, grid_ring_line(gd, yy));
+	grid_block_free_all(gd);
+
+	if (gd->dedup != NULL)
+		xfree(gd->dedup);
+
+	/* Empty the free lists. */
+	gd->poolsx = 0;
+	grid_check_pool(gd);
 
 	xfree(gd->linedata);
 
@@ -131,28 +210,33 @@ grid_destroy(struct grid *gd)
 int
 grid_compare(struct grid *ga, struct grid *gb)
 {
-	struct grid_line	*gla, *glb;
-	struct grid_cell	*gca, *gcb;
-	struct grid_utf8	*gua, *gub;
+	const struct grid_line	*gla, *glb;
+	const struct grid_cell	*gca, *gcb;
+	const struct grid_utf8	*gua, *gub;
 	u_int			 xx, yy;
 
 	if (ga->sx != gb->sx || ga->sy != ga->sy)
 		return (1);
 
 	for (yy = 0; yy < ga->sy; yy++) {
-		gla = &ga->linedata[yy];
-		glb = &gb->linedata[yy];
+		gla = grid_peek_line(ga, ga->hsize + yy);
+		glb = grid_peek_line(gb, gb->hsize + yy);
 		if (gla->cellsize != glb->cellsize)
 			return (1);
 		for (xx = 0; xx < ga->sx; xx++) {
-			gca = &gla->celldata[xx];
-			gcb = &glb->celldata[xx];
+			gca = grid_peek_cell(ga, xx, ga->hsize + yy);
+			gcb = grid_peek_cell(gb, xx, gb->hsize + yy);
 			if (memcmp(gca, gcb, sizeof (struct grid_cell)) != 0)
 				return (1);
 			if (!(gca->flags & GRID_FLAG_UTF8))
 				continue;
-			gua = &gla->utf8data[xx];
-			gub = &glb->utf8data[xx];
+			gua = grid_line_utf8(gla, xx);
+			gub = grid_line_utf8(glb, xx);
+			if (gua == NULL || gub == NULL) {
+				if (gua != gub)
+					return (1);
+				continue;
+			}
 			if (memcmp(gua, gub, sizeof (struct grid_utf8)) != 0)
 				return (1);
 		}
@@ -161,109 +245,806 @@ grid_compare(struct grid *ga, struct grid *gb)
 	return (0);
 }
 
+/* Empty the free lists if the grid width has changed. */
+void
+grid_check_pool(struct grid *gd)
+{
+	u_int	i;
+
+	if (gd->poolsx == gd->sx)
+		return;
+
+	for (i = 0; i < ARRAY_LENGTH(&gd->cellpool); i++)
+		xfree(ARRAY_ITEM(&gd->cellpool, i));
+	ARRAY_FREE(&gd->cellpool);
+
+	gd->poolsx = gd->sx;
+}
+
 /*
- * Collect lines from the history if at the limit. Free the top (oldest) 10%
- * and shift up.
+ * Make sure a line has storage for at least sx cells. Lines up to the screen
+ * width get a whole screen width, taken from the free list if possible.
  */
 void
-grid_collect_history(struct grid *gd)
+grid_reserve_cells(struct grid *gd, struct grid_line *gl, u_int sx)
 {
-	u_int	yy;
+	if (sx <= gl->cellalloc) {
+		if (sx > gl->cellsize)
+			gd->poolsaved++;
+		return;
+	}
 
-	GRID_DEBUG(gd, "");
+	grid_check_pool(gd);
+	if (sx <= gd->sx) {
+		if (gl->cellalloc == 0 && !ARRAY_EMPTY(&gd->cellpool)) {
+			gl->celldata = ARRAY_LAST(&gd->cellpool);
+			gl->cellalloc = gd->sx;
+			gd->cellpool.num--;
 
-	if (gd->hsize < gd->hlimit)
+			gd->poolsaved++;
+			return;
+		}
+		sx = gd->sx;
+	}
+
+	gl->celldata = xrealloc(gl->celldata, sx, sizeof *gl->celldata);
+	gl->cellalloc = sx;
+}
+
+/* Find the first UTF-8 entry at or after px. */
+u_int
+grid_search_utf8(const struct grid_line *gl, u_int px)
+{
+	u_int	lo, hi, mid;
+
+	lo = 0;
+	hi = gl->utf8size;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (gl->utf8data[mid].px < px)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return (lo);
+}
+
+/* Get the UTF-8 data for a cell, or NULL if it has none. */
+const struct grid_utf8 *
+grid_line_utf8(const struct grid_line *gl, u_int px)
+{
+	u_int	i;
+
+	i = grid_search_utf8(gl, px);
+	if (i == gl->utf8size || gl->utf8data[i].px != px)
+		return (NULL);
+	return (&gl->utf8data[i].gu);
+}
+
+/* Get the UTF-8 data for a cell for writing, adding an entry if needed. */
+struct grid_utf8 *
+grid_line_add_utf8(struct grid_line *gl, u_int px)
+{
+	struct grid_utf8_entry	*ge;
+	u_int			 i;
+
+	i = grid_search_utf8(gl, px);
+	if (i != gl->utf8size && gl->utf8data[i].px == px)
+		return (&gl->utf8data[i].gu);
+
+	if (gl->utf8size == gl->utf8alloc) {
+		gl->utf8alloc = gl->utf8alloc == 0 ? 4 : gl->utf8alloc * 2;
+		gl->utf8data = xrealloc(
+		    gl->utf8data, gl->utf8alloc, sizeof *gl->utf8data);
+	}
+	ge = &gl->utf8data[i];
+	memmove(ge + 1, ge, (gl->utf8size - i) * sizeof *ge);
+	gl->utf8size++;
+
+	memset(ge, 0, sizeof *ge);
+	ge->px = px;
+	return (&ge->gu);
+}
+
+/* Sort the UTF-8 entries after their columns have been changed. */
+void
+grid_sort_utf8(struct grid_line *gl)
+{
+	struct grid_utf8_entry	ge;
+	u_int			i, j;
+
+	for (i = 1; i < gl->utf8size; i++) {
+		memcpy(&ge, &gl->utf8data[i], sizeof ge);
+		for (j = i; j > 0 && gl->utf8data[j - 1].px > ge.px; j--) {
+			memcpy(&gl->utf8data[j],
+			    &gl->utf8data[j - 1], sizeof ge);
+		}
+		memcpy(&gl->utf8data[j], &ge, sizeof ge);
+	}
+}
+
+/*
+ * Free the storage for a line, putting it on the free list if possible. Shared
+ * storage is only freed with the last line using it.
+ */
+void
+grid_free_line(struct grid *gd, struct grid_line *gl)
+{
+	if (gl->references != NULL) {
+		if (--*gl->references != 0) {
+			memset(gl, 0, sizeof *gl);
+			return;
+		}
+		xfree(gl->references);
+	}
+
+	grid_check_pool(gd);
+
+	if (gl->celldata != NULL) {
+		if (gl->cellalloc == gd->sx &&
+		    ARRAY_LENGTH(&gd->cellpool) < gd->sy)
+			ARRAY_ADD(&gd->cellpool, gl->celldata);
+		else
+			xfree(gl->celldata);
+	}
+	if (gl->utf8data != NULL)
+		xfree(gl->utf8data);
+
+	if (gl->rundata != NULL)
+		grid_free_runs(gl);
+
+	memset(gl, 0, sizeof *gl);
+}
+
+/* Free a packed line's runs and text, releasing their styles. */
+void
+grid_free_runs(struct grid_line *gl)
+{
+	u_int	i;
+
+	for (i = 0; i < gl->runsize; i++)
+		grid_style_free(gl->rundata[i].style);
+	xfree(gl->rundata);
+	gl->rundata = NULL;
+	gl->runsize = 0;
+}
+
+/* Give a line its own copy of any storage it shares with other lines. */
+void
+grid_unshare_line(struct grid *gd, struct grid_line *gl)
+{
+	struct grid_cell	*celldata;
+	struct grid_run		*rundata;
+	struct grid_utf8_entry	*utf8data;
+	size_t			 size;
+	u_int			 i;
+
+	if (gl->references == NULL)
+		return;
+	if (--*gl->references == 0) {
+		xfree(gl->references);
+		gl->references = NULL;
 		return;
+	}
+	gl->references = NULL;
+
+	if (gl->rundata != NULL) {
+		size = gl->runsize * sizeof *gl->rundata + gl->cellsize;
+		rundata = gl->rundata;
+		gl->rundata = xmalloc(size);
+		memcpy(gl->rundata, rundata, size);
+		for (i = 0; i < gl->runsize; i++)
+			grid_style_ref(gl->rundata[i].style);
+	}
+
+	if (gl->celldata != NULL) {
+		celldata = gl->celldata;
+		gl->celldata = NULL;
+		gl->cellalloc = 0;
+		grid_reserve_cells(gd, gl, gl->cellsize);
+		memcpy(gl->celldata,
+		    celldata, gl->cellsize * sizeof *gl->celldata);
+	}
+
+	if (gl->utf8data != NULL) {
+		utf8data = gl->utf8data;
+		gl->utf8data = NULL;
+		gl->utf8alloc = 0;
+		if (gl->utf8size != 0) {
+			gl->utf8data = xcalloc(
+			    gl->utf8size, sizeof *gl->utf8data);
+			memcpy(gl->utf8data, utf8data,
+			    gl->utf8size * sizeof *gl->utf8data);
+			gl->utf8alloc = gl->utf8size;
+		}
+	}
+}
 
-	yy = gd->hlimit / 10;
-	if (yy < 1)
-		yy = 1;
+/* Get the size of a line's storage. */
+size_t
+grid_line_size(const struct grid_line *gl)
+{
+	size_t	size;
+
+	size = gl->cellalloc * sizeof *gl->celldata;
+	size += gl->utf8alloc * sizeof *gl->utf8data;
+	if (gl->rundata != NULL)
+		size += gl->runsize * sizeof *gl->rundata + gl->cellsize;
+	return (size);
+}
 
-	grid_move_lines(gd, 0, yy, gd->hsize + gd->sy - yy);
-	gd->hsize -= yy;
+/*
+ * Get the memory a line adds to hbytes when it is moved into the history, or
+ * takes away when it leaves. Shared storage is counted with the first line to
+ * use it and uncounted with the last.
+ */
+size_t
+grid_history_line_size(const struct grid_line *gl)
+{
+	if (gl->references != NULL && *gl->references != 1)
+		return (sizeof *gl);
+	return (grid_line_size(gl) + sizeof *gl);
+}
+
+/*
+ * Get the memory used by the history, including compressed blocks not spilled
+ * to disk. This is counted as lines and blocks move in and out.
+ */
+size_t
+grid_history_size(struct grid *gd)
+{
+	return (gd->hbytes);
 }
 
 /*
- * Scroll the entire visible screen, moving one line into the history. Just
- * allocate a new line at the bottom and move the history size indicator.
+ * Pack or trim a line's storage once it is no longer likely to be written to.
+ * Storage for empty lines is given back to the free list.
  */
 void
-grid_scroll_history(struct grid *gd)
+grid_trim_line(struct grid *gd, struct grid_line *gl)
 {
-	u_int	yy;
+	struct grid_line	 empty;
+	struct grid_utf8_entry	*ge;
+	u_int			 i, n;
+
+	/* Shared storage is left alone until the line is written to. */
+	if (gl->references != NULL && *gl->references != 1)
+		return;
+	grid_unshare_line(gd, gl);
+
+	/* Drop UTF-8 data for cells which have been overwritten or cleared. */
+	if (gl->celldata != NULL) {
+		n = 0;
+		for (i = 0; i < gl->utf8size; i++) {
+			ge = &gl->utf8data[i];
+			if (ge->px >= gl->cellsize ||
+			    !(gl->celldata[ge->px].flags & GRID_FLAG_UTF8))
+				continue;
+			if (n != i)
+				memcpy(&gl->utf8data[n], ge, sizeof *ge);
+			n++;
+		}
+		gl->utf8size = n;
+	}
+
+	memset(&empty, 0, sizeof empty);
+	if (gl->celldata != NULL &&
+	    (gl->cellsize == 0 || grid_pack_line(gl) == 0)) {
+		empty.celldata = gl->celldata;
+		empty.cellalloc = gl->cellalloc;
+		gl->celldata = NULL;
+		gl->cellalloc = 0;
+	} else if (gl->cellalloc > gl->cellsize) {
+		gl->celldata = xrealloc(
+		    gl->celldata, gl->cellsize, sizeof *gl->celldata);
+		gl->cellalloc = gl->cellsize;
+	}
+	if (gl->utf8size == 0 && gl->utf8data != NULL) {
+		xfree(gl->utf8data);
+		gl->utf8data = NULL;
+		gl->utf8alloc = 0;
+	} else if (gl->utf8alloc > gl->utf8size) {
+		gl->utf8data = xrealloc(
+		    gl->utf8data, gl->utf8size, sizeof *gl->utf8data);
+		gl->utf8alloc = gl->utf8size;
+	}
+	grid_free_line(gd, &empty);
+}
+
+/* Hash a trimmed line's contents (FNV-1a). */
+uint32_t
+grid_hash_line(const struct grid_line *gl)
+{
+	const u_char	*ptr, *end;
+	uint32_t	 hash;
+	u_int		 i;
+
+	hash = 2166136261U;
+	hash = (hash ^ gl->flags) * 16777619;
+	hash = (hash ^ gl->cellsize) * 16777619;
+
+	if (gl->rundata != NULL) {
+		ptr = (const u_char *) gl->rundata;
+		end = grid_line_text(gl) + gl->cellsize;
+	} else {
+		ptr = (const u_char *) gl->celldata;
+		end = ptr + gl->cellsize * sizeof *gl->celldata;
+	}
+	for (; ptr < end; ptr++)
+		hash = (hash ^ *ptr) * 16777619;
+
+	for (i = 0; i < gl->utf8size; i++) {
+		ptr = (const u_char *) &gl->utf8data[i];
+		end = ptr + sizeof *gl->utf8data;
+		for (; ptr < end; ptr++)
+			hash = (hash ^ *ptr) * 16777619;
+	}
+
+	return (hash);
+}
+
+/* Compare two trimmed lines. */
+int
+grid_equal_lines(const struct grid_line *gla, const struct grid_line *glb)
+{
+	size_t	size;
+
+	if (gla->flags != glb->flags || gla->cellsize != glb->cellsize)
+		return (0);
+	if (gla->runsize != glb->runsize || gla->utf8size != glb->utf8size)
+		return (0);
+	if ((gla->rundata == NULL) != (glb->rundata == NULL))
+		return (0);
+
+	if (gla->rundata != NULL) {
+		size = gla->runsize * sizeof *gla->rundata + gla->cellsize;
+		if (memcmp(gla->rundata, glb->rundata, size) != 0)
+			return (0);
+	} else {
+		size = gla->cellsize * sizeof *gla->celldata;
+		if (size != 0 &&
+		    memcmp(gla->celldata, glb->celldata, size) != 0)
+			return (0);
+	}
+
+	size = gla->utf8size * sizeof *gla->utf8data;
+	if (size != 0 && memcmp(gla->utf8data, glb->utf8data, size) != 0)
+		return (0);
+	return (1);
+}
+
+/*
+ * Share a line being moved into the history with an identical recent history
+ * line if there is one; otherwise remember it in place of the last line with
+ * the same hash. The line must be trimmed and about to be line hsize. Entries
+ * are found again by their number so they may be stale, so the line there is
+ * always compared.
+ */
+void
+grid_dedup_line(struct grid *gd, struct grid_line *gl)
+{
+	struct grid_dedup	*gdd;
+	struct grid_line	*found;
+	uint32_t		 hash;
+	u_int			 py;
+
+	if (gl->references != NULL || gl->cellsize == 0)
+		return;
+	if (gl->celldata == NULL && gl->rundata == NULL)
+		return;
+
+	if (gd->dedup == NULL)
+		gd->dedup = xcalloc(GRID_DEDUP_SIZE, sizeof *gd->dedup);
+	gd->dedupsearched++;
+
+	hash = grid_hash_line(gl);
+	gdd = &gd->dedup[hash % GRID_DEDUP_SIZE];
+
+	py = gdd->id - gd->hdropped;
+	if (gdd->hash == hash && py >= gd->hcomp && py < gd->hsize) {
+		found = grid_ring_line(gd, py);
+		if (grid_equal_lines(found, gl)) {
+			if (found->references == NULL) {
+				found->references =
+				    xmalloc(sizeof *found->references);
+				*found->references = 1;
+			}
+			(*found->references)++;
+
+			grid_free_line(gd, gl);
+			memcpy(gl, found, sizeof *gl);
+
+			gd->deduphits++;
+			return;
+		}
+	}
+
+	gdd->hash = hash;
+	gdd->id = gd->hdropped + gd->hsize;
+}
+
+/*
+ * Pack a line's cells into text and runs of styles. The cells are left for the
+ * caller to free. Fails if packing would not save anything or there is no room
+ * for a new style.
+ */
+int
+grid_pack_line(struct grid_line *gl)
+{
+	const struct grid_cell	*gc;
+	struct grid_run		*run;
+	u_char			*text;
+	u_int			 xx, n, key;
+
+	n = 1;
+	for (xx = 1; xx < gl->cellsize; xx++) {
+		if (grid_style_key(&gl->celldata[xx]) !=
+		    grid_style_key(&gl->celldata[xx - 1]))
+			n++;
+	}
+	if (n * sizeof *gl->rundata + gl->cellsize >=
+	    gl->cellsize * sizeof *gl->celldata)
+		return (-1);
+
+	/* The text goes after the runs, so space is needed for all of them. */
+	gl->rundata = xmalloc(n * sizeof *gl->rundata + gl->cellsize);
+	gl->runsize = 0;
+
+	key = 0;
+	for (xx = 0; xx < gl->cellsize; xx++) {
+		gc = &gl->celldata[xx];
+		if (xx != 0 && grid_style_key(gc) == key)
+			continue;
+		key = grid_style_key(gc);
+
+		run = &gl->rundata[gl->runsize];
+		if ((run->style = grid_style_add(gc)) == GRID_STYLE_NONE) {
+			grid_free_runs(gl);
+			return (-1);
+		}
+		run->px = xx;
+		gl->runsize++;
+	}
+
+	text = grid_line_text(gl);
+	for (xx = 0; xx < gl->cellsize; xx++)
+		text[xx] = gl->celldata[xx].data;
+	return (0);
+}
+
+/* Unpack a packed line back into cells. */
+void
+grid_unpack_line(struct grid *gd, struct grid_line *gl)
+{
+	struct grid_cell	 gc;
+	const struct grid_run	*run;
+	const u_char		*text;
+	u_int			 xx;
+
+	grid_reserve_cells(gd, gl, gl->cellsize);
+	text = grid_line_text(gl);
+
+	run = gl->rundata;
+	grid_style_set(run->style, &gc);
+	for (xx = 0; xx < gl->cellsize; xx++) {
+		if (run + 1 < gl->rundata + gl->runsize && run[1].px == xx) {
+			run++;
+			grid_style_set(run->style, &gc);
+		}
+		gc.data = text[xx];
+		memcpy(&gl->celldata[xx], &gc, sizeof gc);
+	}
+
+	grid_free_runs(gl);
+}
+
+/* Build a cell from a packed line. */
+void
+grid_packed_cell(const struct grid_line *gl, u_int px, struct grid_cell *gc)
+{
+	const struct grid_run	*run;
+	u_int			 lo, hi, mid;
+
+	/* Find the last run starting at or before px. */
+	lo = 0;
+	hi = gl->runsize;
+	while (hi - lo > 1) {
+		mid = (lo + hi) / 2;
+		if (gl->rundata[mid].px <= px)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	run = &gl->rundata[lo];
+
+	grid_style_set(run->style, gc);
+	gc->data = grid_line_text(gl)[px];
+}
+
+/* Get line for reading. The line may be packed. */
+const struct grid_line *
+grid_peek_line(struct grid *gd, u_int py)
+{
+	if (py < gd->hcomp)
+		return (grid_block_peek_line(gd, py));
+	return (grid_ring_line(gd, py));
+}
+
+/* Get line for writing. The caller must have checked py. */
+struct grid_line *
+grid_get_line(struct grid *gd, u_int py)
+{
+	struct grid_line	*gl;
 
+	gl = grid_ring_line(gd, py);
+	if (py < gd->hsize) {
+		gd->hbytes -= grid_history_line_size(gl);
+		grid_unshare_line(gd, gl);
+		if (gl->rundata != NULL)
+			grid_unpack_line(gd, gl);
+		gd->hbytes += grid_history_line_size(gl);
+		return (gl);
+	}
+	grid_unshare_line(gd, gl);
+	if (gl->rundata != NULL)
+		grid_unpack_line(gd, gl);
+	return (gl);
+}
+
+/*
+ * Get a line's entry in the ring, without unpacking it. Compressed lines are
+ * moved back into the ring first.
+ */
+struct grid_line *
+grid_ring_line(struct grid *gd, u_int py)
+{
+	u_int	idx;
+
+	if (py < gd->hcomp)
+		grid_block_thaw(gd, py);
+
+	idx = gd->loffset + (py - gd->hcomp);
+	if (idx >= gd->lsize)
+		idx -= gd->lsize;
+	return (&gd->linedata[idx]);
+}
+
+/*
+ * Make sure the ring has space for lines up to ny (compressed lines are not in
+ * the ring). The ring is grown geometrically (but not beyond what the history
+ * limit allows) so that scrolling into a growing history does not reallocate on
+ * every line.
+ */
+void
+grid_reserve_lines(struct grid *gd, u_int ny)
+{
+	struct grid_line	*linedata;
+	u_int			 lsize, first;
+
+	ny -= gd->hcomp;
+	if (ny <= gd->lsize)
+		return;
+
+	lsize = gd->lsize * 2;
+	if (lsize > gd->hlimit + gd->sy + 1)
+		lsize = gd->hlimit + gd->sy + 1;
+	if (lsize < ny)
+		lsize = ny;
+
+	/* Unwrap the ring into the new array, so line 0 is at the start. */
+	linedata = xcalloc(lsize, sizeof *linedata);
+	first = gd->lsize - gd->loffset;
+	memcpy(linedata, &gd->linedata[gd->loffset], first * sizeof *linedata);
+	memcpy(&linedata[first], gd->linedata, gd->loffset * sizeof *linedata);
+	xfree(gd->linedata);
+
+	gd->linedata = linedata;
+	gd->lsize = lsize;
+	gd->loffset = 0;
+}
+
+/*
+ * Collect lines from the history if over the limit. The oldest lines are freed
+ * and the start of the ring moved past them.
+ */
+void
+grid_collect_history(struct grid *gd)
+{
 	GRID_DEBUG(gd, "");
 
-	yy = gd->hsize + gd->sy;
-	gd->linedata = xrealloc(gd->linedata, yy + 1, sizeof *gd->linedata);
-	memset(&gd->linedata[yy], 0, sizeof gd->linedata[yy]);
+	while (gd->hsize > gd->hlimit) {
+		if (gd->hcomp != 0) {
+			grid_block_drop_line(gd);
+			gd->hsize--;
+			gd->hdropped++;
+			continue;
+		}
+		gd->hbytes -= grid_history_line_size(grid_ring_line(gd, 0));
+		grid_clear_lines(gd, 0, 1);
 
-	gd->hsize++;
+		if (++gd->loffset == gd->lsize)
+			gd->loffset = 0;
+		gd->hsize--;
+		gd->hdropped++;
+	}
 }
 
-/* Scroll a region up, moving the top line into the history. */
+/* Drop up to ny of the oldest lines of history. */
 void
-grid_scroll_history_region(struct grid *gd, u_int upper, u_int lower)
+grid_drop_history(struct grid *gd, u_int ny)
 {
-	struct grid_line	*gl_history, *gl_upper, *gl_lower;
-	u_int			 yy;
+	u_int	hlimit;
 
-	GRID_DEBUG(gd, "upper=%u, lower=%u", upper, lower);
+	GRID_DEBUG(gd, "ny=%u", ny);
 
-	/* Create a space for a new line. */
-	yy = gd->hsize + gd->sy;
-	gd->linedata = xrealloc(gd->linedata, yy + 1, sizeof *gd->linedata);
+	if (ny > gd->hsize)
+		ny = gd->hsize;
 
-	/* Move the entire screen down to free a space for this line. */
-	gl_history = &gd->linedata[gd->hsize];
-	memmove(gl_history + 1, gl_history, gd->sy * sizeof *gl_history);
+	hlimit = gd->hlimit;
+	gd->hlimit = gd->hsize - ny;
+	grid_collect_history(gd);
+	gd->hlimit = hlimit;
+}
 
-	/* Adjust the region and find its start and end. */
-	upper++;
-	gl_upper = &gd->linedata[upper];
-	lower++;
-	gl_lower = &gd->linedata[lower];
+/* Clear all the history, keeping the visible screen. */
+void
+grid_clear_history(struct grid *gd)
+{
+	GRID_DEBUG(gd, "");
 
-	/* Move the line into the history. */
-	memcpy(gl_history, gl_upper, sizeof *gl_history);
+	gd->hdropped += gd->hsize;
 
-	/* Then move the region up and clear the bottom line. */
-	memmove(gl_upper, gl_upper + 1, (lower - upper) * sizeof *gl_upper);
-	memset(gl_lower, 0, sizeof *gl_lower);
+	/* Lines pulled from the history onto the screen may be compressed. */
+	if (gd->hcomp > gd->hsize)
+		grid_block_thaw(gd, gd->hsize);
+	grid_block_free_all(gd);
 
-	/* Move the history offset down over the line. */
-	gd->hsize++;
+	grid_clear_lines(gd, 0, gd->hsize);
+
+	gd->loffset += gd->hsize;
+	if (gd->loffset >= gd->lsize)
+		gd->loffset -= gd->lsize;
+	gd->hsize = 0;
+	gd->hbytes = 0;
 }
 
-/* Expand line to fit to cell. */
+/*
+ * Move ny lines from the top of the screen into the history, without
+ * scrolling. The lines are not trimmed since they may still be written.
+ */
 void
-grid_expand_line(struct grid *gd, u_int py, u_int sx)
+grid_grow_history(struct grid *gd, u_int ny)
 {
 	struct grid_line	*gl;
-	u_int			 xx;
+	u_int			 yy;
 
-	gl = &gd->linedata[py];
-	if (sx <= gl->cellsize)
+	for (yy = gd->hsize; yy < gd->hsize + ny; yy++) {
+		if (yy < gd->hcomp)
+			continue;
+		gl = grid_ring_line(gd, yy);
+		gd->hbytes += grid_history_line_size(gl);
+	}
+	gd->hsize += ny;
+}
+
+/*
+ * Move the last ny lines of the history back onto the screen. They are given
+ * their own storage so the history does not share any with the screen.
+ */
+void
+grid_shrink_history(struct grid *gd, u_int ny)
+{
+	struct grid_line	*gl;
+	u_int			 yy;
+
+	for (yy = gd->hsize - ny; yy < gd->hsize; yy++) {
+		if (yy < gd->hcomp)
+			continue;
+		gl = grid_ring_line(gd, yy);
+		gd->hbytes -= grid_history_line_size(gl);
+		grid_unshare_line(gd, gl);
+	}
+	gd->hsize -= ny;
+}
+
+/*
+ * Scroll the entire visible screen, moving ny lines into the history. Just
+ * take the next (empty) line in the ring at the bottom and move the history
+ * size indicator, once for each line.
+ */
+void
+grid_scroll_history(struct grid *gd, u_int ny)
+{
+	struct grid_line	*gl;
+
+	GRID_DEBUG(gd, "ny=%u", ny);
+
+	for (; ny > 0; ny--) {
+		grid_reserve_lines(gd, gd->hsize + gd->sy + 1);
+		gl = grid_ring_line(gd, gd->hsize);
+		grid_trim_line(gd, gl);
+		grid_dedup_line(gd, gl);
+		gd->hbytes += grid_history_line_size(gl);
+		gd->hsize++;
+
+		grid_collect_history(gd);
+	}
+}
+
+/*
+ * Scroll a region up by ny lines, moving the top lines into the history. The
+ * region must be at least ny lines high.
+ */
+void
+grid_scroll_history_region(struct grid *gd, u_int upper, u_int lower, u_int ny)
+{
+	struct grid_line	*gl_history;
+	u_int			 yy;
+
+	GRID_DEBUG(gd, "upper=%u, lower=%u, ny=%u", upper, lower, ny);
+
+	if (ny == 0)
 		return;
 
-	gl->celldata = xrealloc(gl->celldata, sx, sizeof *gl->celldata);
-	for (xx = gl->cellsize; xx < sx; xx++)
-		grid_put_cell(gd, xx, py, &grid_default_cell);
-	gl->cellsize = sx;
+	/* Create space for the new lines at the end of the ring. */
+	yy = gd->hsize + gd->sy;
+	grid_reserve_lines(gd, yy + ny);
+
+	/*
+	 * Move the lines below the region down and leave the lines after the
+	 * region empty. The region itself does not move: adding the history
+	 * lines below moves it up by ny on screen.
+	 */
+	for (yy += ny - 1; yy > lower + ny; yy--)
+		memcpy(grid_ring_line(gd, yy), grid_ring_line(gd, yy - ny),
+		    sizeof *gl_history);
+	for (yy = lower + 1; yy <= lower + ny; yy++)
+		memset(grid_ring_line(gd, yy), 0, sizeof *gl_history);
+
+	/*
+	 * Take the top lines of the region, move the lines above the region
+	 * down, and then put the top lines at the end of the history.
+	 */
+	gl_history = xcalloc(ny, sizeof *gl_history);
+	for (yy = 0; yy < ny; yy++) {
+		memcpy(&gl_history[yy], grid_ring_line(gd, upper + yy),
+		    sizeof *gl_history);
+	}
+	for (yy = upper + ny - 1; yy >= gd->hsize + ny; yy--)
+		memcpy(grid_ring_line(gd, yy), grid_ring_line(gd, yy - ny),
+		    sizeof *gl_history);
+	for (yy = 0; yy < ny; yy++) {
+		grid_trim_line(gd, &gl_history[yy]);
+		grid_dedup_line(gd, &gl_history[yy]);
+		gd->hbytes += grid_history_line_size(&gl_history[yy]);
+		memcpy(grid_ring_line(gd, gd->hsize), &gl_history[yy],
+		    sizeof *gl_history);
+
+		/* Move the history offset down over the line. */
+		gd->hsize++;
+	}
+	xfree(gl_history);
+
+	grid_collect_history(gd);
 }
 
-/* Expand line to fit to cell for UTF-8. */
+/* Expand line to fit to cell. */
 void
-grid_expand_line_utf8(struct grid *gd, u_int py, u_int sx)
+grid_expand_line(struct grid *gd, u_int py, u_int sx)
 {
 	struct grid_line	*gl;
+	u_int			 xx;
 
-	gl = &gd->linedata[py];
-	if (sx <= gl->utf8size)
+	gl = grid_get_line(gd, py);
+	if (sx <= gl->cellsize)
 		return;
 
-	gl->utf8data = xrealloc(gl->utf8data, sx, sizeof *gl->utf8data);
-	gl->utf8size = sx;
+	grid_reserve_cells(gd, gl, sx);
+	for (xx = gl->cellsize; xx < sx; xx++) {
+		memcpy(&gl->celldata[xx],
+		    &grid_default_cell, sizeof gl->celldata[xx]);
+	}
+	gl->cellsize = sx;
 }
 
 /* Get cell for reading. */
@@ -275,9 +1056,25 @@ grid_peek_cell(struct grid *gd, u_int px, u_int py)
 	if (grid_check_y(gd, py) != 0)
 		return (&grid_default_cell);
 
-	if (px >= gd->linedata[py].cellsize)
+	return (grid_peek_cell_unchecked(gd, px, py));
+}
+
+/* Get cell for reading, with coordinates the caller knows are in range. */
+const struct grid_cell *
+grid_peek_cell_unchecked(struct grid *gd, u_int px, u_int py)
+{
+	const struct grid_line	*gl;
+
+	grid_assert_xy(gd, px, py);
+
+	gl = grid_peek_line(gd, py);
+	if (px >= gl->cellsize)
 		return (&grid_default_cell);
-	return (&gd->linedata[py].celldata[px]);
+	if (gl->rundata != NULL) {
+		grid_packed_cell(gl, px, &gd->peekcell);
+		return (&gd->peekcell);
+	}
+	return (&gl->celldata[px]);
 }
 
 /* Get cell at relative position (for writing). */
@@ -290,7 +1087,7 @@ grid_get_cell(struct grid *gd, u_int px, u_int py)
 		return (NULL);
 
 	grid_expand_line(gd, py, px + 1);
-	return (&gd->linedata[py].celldata[px]);
+	return (&grid_get_line(gd, py)->celldata[px]);
 }
 
 /* Set cell at relative position. */
@@ -303,10 +1100,62 @@ grid_set_cell(
 	if (grid_check_y(gd, py) != 0)
 		return;
 
+	grid_set_cell_unchecked(gd, px, py, gc);
+}
+
+/* Set cell, with coordinates the caller knows are in range. */
+void
+grid_set_cell_unchecked(
+    struct grid *gd, u_int px, u_int py, const struct grid_cell *gc)
+{
+	grid_assert_xy(gd, px, py);
+
 	grid_expand_line(gd, py, px + 1);
 	grid_put_cell(gd, px, py, gc);
 }
 
+/*
+ * Set a run of cells with the same attributes and the characters from buf.
+ * The characters must not be UTF-8.
+ */
+void
+grid_set_cells(struct grid *gd, u_int px, u_int py,
+    const struct grid_cell *gc, const u_char *buf, u_int nx)
+{
+	if (nx == 0)
+		return;
+	if (grid_check_x(gd, px) != 0)
+		return;
+	if (grid_check_x(gd, px + nx - 1) != 0)
+		return;
+	if (grid_check_y(gd, py) != 0)
+		return;
+
+	grid_set_cells_unchecked(gd, px, py, gc, buf, nx);
+}
+
+/* Set a run of cells, with coordinates the caller knows are in range. */
+void
+grid_set_cells_unchecked(struct grid *gd, u_int px, u_int py,
+    const struct grid_cell *gc, const u_char *buf, u_int nx)
+{
+	struct grid_line	*gl;
+	struct grid_cell	*gce;
+	u_int			 xx;
+
+	if (nx == 0)
+		return;
+	grid_assert_xy(gd, px + nx - 1, py);
+
+	grid_expand_line(gd, py, px + nx);
+	gl = grid_get_line(gd, py);
+	for (xx = 0; xx < nx; xx++) {
+		gce = &gl->celldata[px + xx];
+		memcpy(gce, gc, sizeof *gce);
+		gce->data = buf[xx];
+	}
+}
+
 /* Get UTF-8 for reading. */
 const struct grid_utf8 *
 grid_peek_utf8(struct grid *gd, u_int px, u_int py)
@@ -316,9 +1165,16 @@ grid_peek_utf8(struct grid *gd, u_int px, u_int py)
 	if (grid_check_y(gd, py) != 0)
 		return (NULL);
 
-	if (px >= gd->linedata[py].utf8size)
-		return (NULL);
-	return (&gd->linedata[py].utf8data[px]);
+	return (grid_peek_utf8_unchecked(gd, px, py));
+}
+
+/* Get UTF-8 for reading, with coordinates the caller knows are in range. */
+const struct grid_utf8 *
+grid_peek_utf8_unchecked(struct grid *gd, u_int px, u_int py)
+{
+	grid_assert_xy(gd, px, py);
+
+	return (grid_line_utf8(grid_peek_line(gd, py), px));
 }
 
 /* Get utf8 at relative position (for writing). */
@@ -330,8 +1186,7 @@ grid_get_utf8(struct grid *gd, u_int px, u_int py)
 	if (grid_check_y(gd, py) != 0)
 		return (NULL);
 
-	grid_expand_line_utf8(gd, py, px + 1);
-	return (&gd->linedata[py].utf8data[px]);
+	return (grid_line_add_utf8(grid_get_line(gd, py), px));
 }
 
 /* Set utf8 at relative position. */
@@ -344,15 +1199,25 @@ grid_set_utf8(
 	if (grid_check_y(gd, py) != 0)
 		return;
 
-	grid_expand_line_utf8(gd, py, px + 1);
-	grid_put_utf8(gd, px, py, gc);
+	grid_set_utf8_unchecked(gd, px, py, gc);
+}
+
+/* Set UTF-8, with coordinates the caller knows are in range. */
+void
+grid_set_utf8_unchecked(
+    struct grid *gd, u_int px, u_int py, const struct grid_utf8 *gc)
+{
+	grid_assert_xy(gd, px, py);
+
+	memcpy(grid_line_add_utf8(grid_get_line(gd, py), px), gc, sizeof *gc);
 }
 
 /* Clear area. */
 void
 grid_clear(struct grid *gd, u_int px, u_int py, u_int nx, u_int ny)
 {
-	u_int	xx, yy;
+	struct grid_line	*gl;
+	u_int			 xx, yy;
 
 	GRID_DEBUG(gd, "px=%u, py=%u, nx=%u, ny=%u", px, py, nx, ny);
 
@@ -374,16 +1239,18 @@ grid_clear(struct grid *gd, u_int px, u_int py, u_int nx, u_int ny)
 		return;
 
 	for (yy = py; yy < py + ny; yy++) {
-		if (px >= gd->linedata[yy].cellsize)
+		gl = grid_get_line(gd, yy);
+		if (px >= gl->cellsize)
 			continue;
-		if (px + nx >= gd->linedata[yy].cellsize) {
-			gd->linedata[yy].cellsize = px;
+		if (px + nx >= gl->cellsize) {
+			gl->cellsize = px;
 			continue;
 		}
 		for (xx = px; xx < px + nx; xx++) {
-			if (xx >= gd->linedata[yy].cellsize)
+			if (xx >= gl->cellsize)
 				break;
-			grid_put_cell(gd, xx, yy, &grid_default_cell);
+			memcpy(&gl->celldata[xx],
+			    &grid_default_cell, sizeof gl->celldata[xx]);
 		}
 	}
 }
@@ -392,8 +1259,7 @@ grid_clear(struct grid *gd, u_int px, u_int py, u_int nx, u_int ny)
 void
 grid_clear_lines(struct grid *gd, u_int py, u_int ny)
 {
-	struct grid_line	*gl;
-	u_int			 yy;
+	u_int	yy;
 
 	GRID_DEBUG(gd, "py=%u, ny=%u", py, ny);
 
@@ -405,14 +1271,8 @@ grid_clear_lines(struct grid *gd, u_int py, u_int ny)
 	if (grid_check_y(gd, py + ny - 1) != 0)
 		return;
 
-	for (yy = py; yy < py + ny; yy++) {
-		gl = &gd->linedata[yy];
-		if (gl->celldata != NULL)
-			xfree(gl->celldata);
-		if (gl->utf8data != NULL)
-			xfree(gl->utf8data);
-		memset(gl, 0, sizeof *gl);
-	}
+	for (yy = py; yy < py + ny; yy++)
+		grid_free_line(gd, grid_ring_line(gd, yy));
 }
 
 /* Move a group of lines. */
@@ -442,14 +1302,24 @@ grid_move_lines(struct grid *gd, u_int dy, u_int py, u_int ny)
 		grid_clear_lines(gd, yy, 1);
 	}
 
-	memmove(
-	    &gd->linedata[dy], &gd->linedata[py], ny * (sizeof *gd->linedata));
+	/* Move the lines one at a time, in the right order to not overlap. */
+	if (dy < py) {
+		for (yy = 0; yy < ny; yy++) {
+			memcpy(grid_ring_line(gd, dy + yy),
+			    grid_ring_line(gd, py + yy), sizeof *gd->linedata);
+		}
+	} else {
+		for (yy = ny; yy > 0; yy--) {
+			memcpy(grid_ring_line(gd, dy + yy - 1),
+			    grid_ring_line(gd, py + yy - 1), sizeof *gd->linedata);
+		}
+	}
 
 	/* Wipe any lines that have been moved (without freeing them). */
 	for (yy = py; yy < py + ny; yy++) {
 		if (yy >= dy && yy < dy + ny)
 			continue;
-		memset(&gd->linedata[yy], 0, sizeof gd->linedata[yy]);
+		memset(grid_ring_line(gd, yy), 0, sizeof *gd->linedata);
 	}
 }
 
@@ -458,7 +1328,8 @@ void
 grid_move_cells(struct grid *gd, u_int dx, u_int px, u_int py, u_int nx)
 {
 	struct grid_line	*gl;
-	u_int			 xx;
+	struct grid_utf8_entry	*ge;
+	u_int			 xx, i, n;
 
 	GRID_DEBUG(gd, "dx=%u, px=%u, py=%u, nx=%u", dx, px, py, nx);
 
@@ -473,18 +1344,28 @@ grid_move_cells(struct grid *gd, u_int dx, u_int px, u_int py, u_int nx)
 		return;
 	if (grid_check_y(gd, py) != 0)
 		return;
-	gl = &gd->linedata[py];
+	gl = grid_get_line(gd, py);
 
 	grid_expand_line(gd, py, px + nx);
 	grid_expand_line(gd, py, dx + nx);
 	memmove(
 	    &gl->celldata[dx], &gl->celldata[px], nx * sizeof *gl->celldata);
 
-	if (gl->utf8data != NULL) {
-		grid_expand_line_utf8(gd, py, px + nx);
-		grid_expand_line_utf8(gd, py, dx + nx);
-		memmove(&gl->utf8data[dx],
-		    &gl->utf8data[px], nx * sizeof *gl->utf8data);
+	/* Move the UTF-8 data too, dropping any for cells overwritten. */
+	if (gl->utf8size != 0) {
+		n = 0;
+		for (i = 0; i < gl->utf8size; i++) {
+			ge = &gl->utf8data[i];
+			if (ge->px >= px && ge->px < px + nx)
+				ge->px = ge->px - px + dx;
+			else if (ge->px >= dx && ge->px < dx + nx)
+				continue;
+			if (n != i)
+				memcpy(&gl->utf8data[n], ge, sizeof *ge);
+			n++;
+		}
+		gl->utf8size = n;
+		grid_sort_utf8(gl);
 	}
 
 	/* Wipe any cells that have been moved. */
@@ -545,14 +1426,17 @@ grid_string_cells(struct grid *gd, u_int px, u_int py, u_int nx)
 /*
  * Duplicate a set of lines between two grids. If there aren't enough lines in
  * either source or destination, the number of lines is limited to the number
- * available.
+ * available. Lines in the ring share their storage with the copy, compressed
+ * lines are copied.
  */
 void
 grid_duplicate_lines(
     struct grid *dst, u_int dy, struct grid *src, u_int sy, u_int ny)
 {
-	struct grid_line	*dstl, *srcl;
-	u_int			 yy;
+	const struct grid_line	*srcl;
+	struct grid_line	*dstl, *gl;
+	size_t			 size;
+	u_int			 yy, i;
 
 	GRID_DEBUG(src, "dy=%u, sy=%u, ny=%u", dy, sy, ny);
 
@@ -563,21 +1447,49 @@ grid_duplicate_lines(
 	grid_clear_lines(dst, dy, ny);
 
 	for (yy = 0; yy < ny; yy++) {
-		srcl = &src->linedata[sy];
-		dstl = &dst->linedata[dy];
+		if (sy >= src->hcomp) {
+			gl = grid_ring_line(src, sy);
+			if (gl->celldata != NULL || gl->rundata != NULL ||
+			    gl->utf8data != NULL) {
+				if (gl->references == NULL) {
+					gl->references =
+					    xmalloc(sizeof *gl->references);
+					*gl->references = 1;
+				}
+				(*gl->references)++;
+			}
+			memcpy(grid_ring_line(dst, dy), gl, sizeof *gl);
+
+			sy++;
+			dy++;
+			continue;
+		}
 
-		memcpy(dstl, srcl, sizeof *dstl);
-		if (srcl->cellsize != 0) {
-			dstl->celldata = xcalloc(
-			    srcl->cellsize, sizeof *dstl->celldata);
+		srcl = grid_peek_line(src, sy);
+		dstl = grid_get_line(dst, dy);
+
+		dstl->flags = srcl->flags;
+		if (srcl->rundata != NULL) {
+			size = srcl->runsize * sizeof *srcl->rundata;
+			size += srcl->cellsize;
+			dstl->rundata = xmalloc(size);
+			memcpy(dstl->rundata, srcl->rundata, size);
+			dstl->runsize = srcl->runsize;
+			for (i = 0; i < dstl->runsize; i++)
+				grid_style_ref(dstl->rundata[i].style);
+			dstl->cellsize = srcl->cellsize;
+		} else if (srcl->cellsize != 0) {
+			grid_reserve_cells(dst, dstl, srcl->cellsize);
 			memcpy(dstl->celldata, srcl->celldata,
 			    srcl->cellsize * sizeof *dstl->celldata);
+			dstl->cellsize = srcl->cellsize;
 		}
 		if (srcl->utf8size != 0) {
 			dstl->utf8data = xcalloc(
 			    srcl->utf8size, sizeof *dstl->utf8data);
 			memcpy(dstl->utf8data, srcl->utf8data,
 			    srcl->utf8size * sizeof *dstl->utf8data);
+			dstl->utf8size = dstl->utf8alloc = srcl->utf8size;
 		}
 
 		sy++;
@@ -161,7 +161,7 @@ input_key(struct window_pane *wp, int key)
 	 * Then try to look this up as an xterm key, if the flag to output them
 	 * is set.
 	 */
-	if (options_get_number(&wp->window->options, "xterm-keys")) {
+	if (options_number(&wp->window->options, OPTC_XTERM_KEYS)) {
 		if ((out = xterm_keys_lookup(key)) != NULL) {
 			bufferevent_write(wp->event, out, strlen(out));
 			xfree(out);
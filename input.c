@@ -55,7 +55,11 @@ void	 input_state_string_next(u_char, struct input_ctx *);
 void	 input_state_string_escape(u_char, struct input_ctx *);
 void	 input_state_utf8(u_char, struct input_ctx *);
 
+size_t	 input_printable(const u_char *, size_t);
+
 void	 input_handle_character(u_char, struct input_ctx *);
+void	 input_handle_characters(struct input_ctx *, size_t);
+size_t	 input_handle_utf8(struct input_ctx *);
 void	 input_handle_c0_control(u_char, struct input_ctx *);
 void	 input_handle_c1_control(u_char, struct input_ctx *);
 void	 input_handle_private_two(u_char, struct input_ctx *);
@@ -237,8 +241,6 @@ input_init(struct window_pane *wp)
 	ictx->saved_cy = 0;
 
 	input_state(ictx, input_state_first);
-
-	ictx->was = 0;
 }
 
 void
@@ -250,18 +252,22 @@ input_free(struct window_pane *wp)
 	ARRAY_FREE(&wp->ictx.args);
 }
 
+/* Parse up to limit bytes of pane output, leaving the rest in the buffer. */
 void
-input_parse(struct window_pane *wp)
+input_parse(struct window_pane *wp, size_t limit)
 {
 	struct input_ctx	*ictx = &wp->ictx;
 	u_char			 ch;
+	size_t			 n;
 
-	if (EVBUFFER_LENGTH(wp->event->input) == ictx->was)
+	if (EVBUFFER_LENGTH(wp->event->input) == 0)
 		return;
 	wp->window->flags |= WINDOW_ACTIVITY;
 
 	ictx->buf = EVBUFFER_DATA(wp->event->input);
 	ictx->len = EVBUFFER_LENGTH(wp->event->input);
+	if (ictx->len > limit)
+		ictx->len = limit;
 	ictx->off = 0;
 
 	ictx->wp = wp;
@@ -273,6 +279,19 @@ input_parse(struct window_pane *wp)
 		screen_write_start(&ictx->ctx, NULL, &wp->base);
 
 	while (ictx->off < ictx->len) {
+		/* Runs of plain text are handled without going byte by byte. */
+		if ((void *) ictx->state == (void *) input_state_first) {
+			n = input_printable(
+			    ictx->buf + ictx->off, ictx->len - ictx->off);
+			if (n != 0) {
+				input_handle_characters(ictx, n);
+				continue;
+			}
+			if (ictx->buf[ictx->off] > 0x7f &&
+			    input_handle_utf8(ictx) != 0)
+				continue;
+		}
+
 		ch = ictx->buf[ictx->off++];
 		ictx->state(ch, ictx);
 	}
@@ -280,7 +299,36 @@ input_parse(struct window_pane *wp)
 	screen_write_stop(&ictx->ctx);
 
 	evbuffer_drain(wp->event->input, ictx->len);
-	ictx->was = EVBUFFER_LENGTH(wp->event->input);
+}
+
+/*
+ * Get the length of the run of printable ASCII (0x20 to 0x7e) at the start of
+ * buf. This is checked a word at a time until a word has a byte outside the
+ * range: in each byte of bad, the top bit is set by bytes with it already set,
+ * by the borrow from subtracting 0x20 and by the borrow from subtracting 1
+ * from zero (0x7f after the xor).
+ */
+size_t
+input_printable(const u_char *buf, size_t len)
+{
+	uint64_t	w, v, bad;
+	size_t		off;
+
+	off = 0;
+	while (len - off >= sizeof w) {
+		memcpy(&w, buf + off, sizeof w);
+		v = w ^ 0x7f7f7f7f7f7f7f7fULL;
+		bad = w;
+		bad |= (w - 0x2020202020202020ULL) & ~w;
+		bad |= (v - 0x0101010101010101ULL) & ~v;
+		if ((bad & 0x8080808080808080ULL) != 0)
+			break;
+		off += sizeof w;
+	}
+
+	while (off < len && buf[off] >= 0x20 && buf[off] < 0x7f)
+		off++;
+	return (off);
 }
 
 void
@@ -589,7 +637,7 @@ input_handle_character(u_char ch, struct input_ctx *ictx)
 {
 	struct window_pane	*wp = ictx->wp;
 
-	if (ch > 0x7f && options_get_number(&wp->window->options, "utf8")) {
+	if (ch > 0x7f && window_cache(wp->window)->utf8) {
 		if (utf8_open(&ictx->utf8data, ch)) {
 			log_debug2("-- utf8 size %zu: %zu: %hhu (%c)",
 			    ictx->utf8data.size, ictx->off, ch, ch);
@@ -603,6 +651,47 @@ input_handle_character(u_char ch, struct input_ctx *ictx)
 	screen_write_cell(&ictx->ctx, &ictx->cell, NULL);
 }
 
+/* Handle a run of n printable ASCII characters. */
+void
+input_handle_characters(struct input_ctx *ictx, size_t n)
+{
+	log_debug2("-- %zu characters: %zu", n, ictx->off);
+
+	ictx->intermediate = '\0';
+	screen_write_cells(&ictx->ctx, &ictx->cell, ictx->buf + ictx->off, n);
+	ictx->off += n;
+}
+
+/*
+ * Handle a run of complete UTF-8 characters, decoded together rather than
+ * through input_state_utf8. Returns the number of bytes used.
+ */
+size_t
+input_handle_utf8(struct input_ctx *ictx)
+{
+	struct utf8_data	list[64];
+	size_t			used;
+	u_int			i, n;
+
+	if (!window_cache(ictx->wp->window)->utf8)
+		return (0);
+
+	n = utf8_decode(ictx->buf + ictx->off,
+	    ictx->len - ictx->off, list, nitems(list), &used);
+	if (n == 0)
+		return (0);
+	log_debug2("-- %u utf8 characters: %zu", n, ictx->off);
+
+	ictx->intermediate = '\0';
+	ictx->cell.flags |= GRID_FLAG_UTF8;
+	for (i = 0; i < n; i++)
+		screen_write_cell(&ictx->ctx, &ictx->cell, &list[i]);
+	ictx->cell.flags &= ~GRID_FLAG_UTF8;
+
+	ictx->off += used;
+	return (used);
+}
+
 void
 input_handle_c0_control(u_char ch, struct input_ctx *ictx)
 {
@@ -792,6 +881,7 @@ void
 input_handle_sequence(u_char ch, struct input_ctx *ictx)
 {
 	struct input_sequence_entry	*entry, find;
+#ifdef DEBUG
 	struct screen	 		*s = ictx->ctx.s;
 	u_int				 i;
 	struct input_arg 		*iarg;
@@ -805,6 +895,7 @@ input_handle_sequence(u_char ch, struct input_ctx *ictx)
 		if (*iarg->data != '\0')
 			log_debug2("      ++ %u: %s", i, iarg->data);
 	}
+#endif
 
 	find.ch = ch;
 	entry = bsearch(&find,
@@ -1148,7 +1239,6 @@ void
 input_handle_sequence_sm(struct input_ctx *ictx)
 {
 	struct window_pane	*wp = ictx->wp;
-	struct options		*oo = &wp->window->options;
 	struct screen		*s = &wp->base;
 	u_int			 sx, sy;
 	uint16_t		 n;
@@ -1179,8 +1269,9 @@ input_handle_sequence_sm(struct input_ctx *ictx)
 		case 1049:
 			if (wp->saved_grid != NULL)
 				break;
-			if (!options_get_number(oo, "alternate-screen"))
+			if (!window_cache(wp->window)->alternate_screen)
 				break;
+			screen_write_flush(&ictx->ctx);
 			sx = screen_size_x(s);
 			sy = screen_size_y(s);
 
@@ -1227,7 +1318,6 @@ void
 input_handle_sequence_rm(struct input_ctx *ictx)
 {
 	struct window_pane	*wp = ictx->wp;
-	struct options		*oo = &wp->window->options;
 	struct screen		*s = &wp->base;
 	u_int			 sx, sy;
 	uint16_t		 n;
@@ -1258,8 +1348,9 @@ input_handle_sequence_rm(struct input_ctx *ictx)
 		case 1049:
 			if (wp->saved_grid == NULL)
 				break;
-			if (!options_get_number(oo, "alternate-screen"))
+			if (!window_cache(wp->window)->alternate_screen)
 				break;
+			screen_write_flush(&ictx->ctx);
 			sx = screen_size_x(s);
 			sy = screen_size_y(s);
 
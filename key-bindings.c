@@ -224,7 +224,7 @@ key_bindings_info(struct cmd_ctx *ctx, const char *fmt, ...)
 	va_list	ap;
 	char   *msg;
 
-	if (options_get_number(&global_options, "quiet"))
+	if (options_number(&global_options, OPTC_QUIET))
 		return;
 
 	va_start(ap, fmt);
@@ -251,7 +251,7 @@ layout_set_main_h(struct window *w)
 	width = w->sx / columns;
 
 	/* Get the main pane height and add one for separator line. */
-	mainheight = options_get_number(&w->options, "main-pane-height") + 1;
+	mainheight = options_number(&w->options, OPTC_MAIN_PANE_HEIGHT) + 1;
 	if (mainheight < PANE_MINIMUM + 1)
 		mainheight = PANE_MINIMUM + 1;
 
@@ -362,7 +362,7 @@ layout_set_main_v(struct window *w)
 	height = w->sy / rows;
 
 	/* Get the main pane width and add one for separator line. */
-	mainwidth = options_get_number(&w->options, "main-pane-width") + 1;
+	mainwidth = options_number(&w->options, OPTC_MAIN_PANE_WIDTH) + 1;
 	if (mainwidth < PANE_MINIMUM + 1)
 		mainwidth = PANE_MINIMUM + 1;
 
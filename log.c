@@ -158,7 +158,11 @@ log_debug(const char *msg, ...)
 	}
 }
 
-/* Log a debug message at level 2. */
+/*
+ * Log a debug message at level 2. These are on the hot paths, so without DEBUG
+ * they are compiled out in tmux.h where the compiler allows it.
+ */
+#ifndef log_debug2
 void printflike1
 log_debug2(const char *msg, ...)
 {
@@ -170,6 +174,7 @@ log_debug2(const char *msg, ...)
 		va_end(ap);
 	}
 }
+#endif
 
 /* Log a critical error, with error string if necessary, and die. */
 __dead void
@@ -49,7 +49,7 @@ window_name_callback(unused int fd, unused short events, void *data)
 	char		*name, *wname;
 
 	queue_window_name(w);	/* XXX even if the option is off? */
-	if (!options_get_number(&w->options, "automatic-rename"))
+	if (!options_number(&w->options, OPTC_AUTOMATIC_RENAME))
 		return;
 
 	if (w->active->screen != &w->active->base)
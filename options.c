@@ -19,87 +19,199 @@
 #include <sys/types.h>
 
 #include <stdarg.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "tmux.h"
 
 /*
- * Option handling; each option has a name, type and value and is stored in
- * a splay tree.
+ * Option handling; each option has a name, type and value. Options are
+ * numbered by the code in their set-option table entry and each tree holds
+ * an array of them indexed by code, with a bitmap of those set in the tree
+ * itself rather than inherited from its parent.
  */
 
-SPLAY_GENERATE(options_tree, options_entry, entry, options_cmp);
+int	options_cmp(const void *, const void *);
+void	options_sort(void);
+void	options_changed(void);
+void	options_free_entry(struct options_entry *);
+struct options_entry *options_add(struct options *, enum options_code);
+
+/* Table entries by code and sorted by name, filled in on first use. */
+const struct set_option_entry *options_entries[NOPTCODE];
+const struct set_option_entry *options_sorted[NOPTCODE];
+u_int	options_nsorted;
+
+/*
+ * Bumped whenever any option is changed. Anything caching option values
+ * compares against it and refreshes them when it differs.
+ */
+u_int	options_generation = 1;
 
 int
-options_cmp(struct options_entry *o1, struct options_entry *o2)
+options_cmp(const void *a, const void *b)
 {
-	return (strcmp(o1->name, o2->name));
+	const struct set_option_entry	*entry1, *entry2;
+
+	entry1 = *(const struct set_option_entry **) a;
+	entry2 = *(const struct set_option_entry **) b;
+	return (strcmp(entry1->name, entry2->name));
+}
+
+void
+options_sort(void)
+{
+	const struct set_option_entry	*tables[] = {
+		set_option_table,
+		set_session_option_table,
+		set_window_option_table
+	};
+	const struct set_option_entry	*entry;
+	u_int				 i;
+
+	for (i = 0; i < nitems(tables); i++) {
+		for (entry = tables[i]; entry->name != NULL; entry++) {
+			if (options_nsorted == NOPTCODE ||
+			    options_entries[entry->code] != NULL)
+				fatalx("bad option table");
+			options_entries[entry->code] = entry;
+			options_sorted[options_nsorted++] = entry;
+		}
+	}
+	if (options_nsorted != NOPTCODE)
+		fatalx("bad option table");
+	qsort(options_sorted,
+	    options_nsorted, sizeof *options_sorted, options_cmp);
+}
+
+/* Find the code for an option name. */
+enum options_code
+options_find_code(const char *name)
+{
+	struct set_option_entry		 key;
+	const struct set_option_entry	*keyp = &key, **entryp;
+
+	if (options_nsorted == 0)
+		options_sort();
+
+	key.name = name;
+	entryp = bsearch(&keyp, options_sorted,
+	    options_nsorted, sizeof *options_sorted, options_cmp);
+	if (entryp == NULL)
+		log_fatalx("unknown option: %s", name);
+	return ((*entryp)->code);
+}
+
+void
+options_changed(void)
+{
+	if (++options_generation == 0)
+		options_generation = 1;
 }
 
 void
 options_init(struct options *oo, struct options *parent)
 {
-	SPLAY_INIT(&oo->tree);
+	oo->slots = NULL;
+	oo->set = NULL;
 	oo->parent = parent;
 }
 
+void
+options_free_entry(struct options_entry *o)
+{
+	if (o->type == OPTIONS_STRING)
+		xfree(o->str);
+	else if (o->type == OPTIONS_DATA)
+		o->freefn(o->data);
+}
+
 void
 options_free(struct options *oo)
 {
-	struct options_entry	*o;
+	u_int	i;
 
-	while (!SPLAY_EMPTY(&oo->tree)) {
-		o = SPLAY_ROOT(&oo->tree);
-		SPLAY_REMOVE(options_tree, &oo->tree, o);
-		xfree(o->name);
-		if (o->type == OPTIONS_STRING)
-			xfree(o->str);
-		else if (o->type == OPTIONS_DATA)
-			o->freefn(o->data);
-		xfree(o);
+	options_changed();
+	if (oo->slots == NULL)
+		return;
+
+	for (i = 0; i < NOPTCODE; i++) {
+		if (bit_test(oo->set, i))
+			options_free_entry(&oo->slots[i]);
 	}
+	xfree(oo->slots);
+	xfree(oo->set);
+	oo->slots = NULL;
+	oo->set = NULL;
 }
 
+/* Find an option set in this tree only. */
 struct options_entry *
-options_find1(struct options *oo, const char *name)
+options_lookup1(struct options *oo, enum options_code code)
 {
-	struct options_entry	p;
+	if (oo->set == NULL || !bit_test(oo->set, code))
+		return (NULL);
+	return (&oo->slots[code]);
+}
 
-	p.name = (char *) name;
-	return (SPLAY_FIND(options_tree, &oo->tree, &p));
+/* Find an option in this tree or its parents. */
+struct options_entry *
+options_lookup(struct options *oo, enum options_code code)
+{
+	for (; oo != NULL; oo = oo->parent) {
+		if (oo->set != NULL && bit_test(oo->set, code))
+			return (&oo->slots[code]);
+	}
+	return (NULL);
 }
 
 struct options_entry *
-options_find(struct options *oo, const char *name)
+options_find1(struct options *oo, const char *name)
 {
-	struct options_entry	*o, p;
+	return (options_lookup1(oo, options_find_code(name)));
+}
 
-	p.name = (char *) name;
-	o = SPLAY_FIND(options_tree, &oo->tree, &p);
-	while (o == NULL) {
-		oo = oo->parent;
-		if (oo == NULL)
-			break;
-		o = SPLAY_FIND(options_tree, &oo->tree, &p);
-	}
-	return (o);
+struct options_entry *
+options_find(struct options *oo, const char *name)
+{
+	return (options_lookup(oo, options_find_code(name)));
 }
 
 void
 options_remove(struct options *oo, const char *name)
 {
-	struct options_entry	*o;
+	enum options_code	code;
 
-	if ((o = options_find1(oo, name)) == NULL)
+	code = options_find_code(name);
+	if (options_lookup1(oo, code) == NULL)
 		return;
+	options_changed();
 
-	SPLAY_REMOVE(options_tree, &oo->tree, o);
-	xfree(o->name);
-	if (o->type == OPTIONS_STRING)
-		xfree(o->str);
-	else if (o->type == OPTIONS_DATA)
-		o->freefn(o->data);
-	xfree(o);
+	options_free_entry(&oo->slots[code]);
+	bit_clear(oo->set, code);
+}
+
+/* Get the slot for an option in this tree, freeing any old value. */
+struct options_entry *
+options_add(struct options *oo, enum options_code code)
+{
+	struct options_entry	*o;
+
+	options_changed();
+	if (oo->slots == NULL) {
+		oo->slots = xcalloc(NOPTCODE, sizeof *oo->slots);
+		if ((oo->set = bit_alloc(NOPTCODE)) == NULL)
+			fatal("bit_alloc failed");
+	}
+
+	o = &oo->slots[code];
+	if (bit_test(oo->set, code))
+		options_free_entry(o);
+	else {
+		bit_set(oo->set, code);
+		o->name = options_entries[code]->name;
+	}
+	return (o);
 }
 
 struct options_entry *printflike3
@@ -108,14 +220,7 @@ options_set_string(struct options *oo, const char *name, const char *fmt, ...)
 	struct options_entry	*o;
 	va_list			 ap;
 
-	if ((o = options_find1(oo, name)) == NULL) {
-		o = xmalloc(sizeof *o);
-		o->name = xstrdup(name);
-		SPLAY_INSERT(options_tree, &oo->tree, o);
-	} else if (o->type == OPTIONS_STRING)
-		xfree(o->str);
-	else if (o->type == OPTIONS_DATA)
-		o->freefn(o->data);
+	o = options_add(oo, options_find_code(name));
 
 	va_start(ap, fmt);
 	o->type = OPTIONS_STRING;
@@ -125,30 +230,29 @@ options_set_string(struct options *oo, const char *name, const char *fmt, ...)
 }
 
 char *
-options_get_string(struct options *oo, const char *name)
+options_string(struct options *oo, enum options_code code)
 {
 	struct options_entry	*o;
 
-	if ((o = options_find(oo, name)) == NULL)
+	if ((o = options_lookup(oo, code)) == NULL)
 		fatalx("missing option");
 	if (o->type != OPTIONS_STRING)
 		fatalx("option not a string");
 	return (o->str);
 }
 
+char *
+options_get_string(struct options *oo, const char *name)
+{
+	return (options_string(oo, options_find_code(name)));
+}
+
 struct options_entry *
 options_set_number(struct options *oo, const char *name, long long value)
 {
 	struct options_entry	*o;
 
-	if ((o = options_find1(oo, name)) == NULL) {
-		o = xmalloc(sizeof *o);
-		o->name = xstrdup(name);
-		SPLAY_INSERT(options_tree, &oo->tree, o);
-	} else if (o->type == OPTIONS_STRING)
-		xfree(o->str);
-	else if (o->type == OPTIONS_DATA)
-		o->freefn(o->data);
+	o = options_add(oo, options_find_code(name));
 
 	o->type = OPTIONS_NUMBER;
 	o->num = value;
@@ -156,31 +260,30 @@ options_set_number(struct options *oo, const char *name, long long value)
 }
 
 long long
-options_get_number(struct options *oo, const char *name)
+options_number(struct options *oo, enum options_code code)
 {
 	struct options_entry	*o;
 
-	if ((o = options_find(oo, name)) == NULL)
+	if ((o = options_lookup(oo, code)) == NULL)
 		fatalx("missing option");
 	if (o->type != OPTIONS_NUMBER)
 		fatalx("option not a number");
 	return (o->num);
 }
 
+long long
+options_get_number(struct options *oo, const char *name)
+{
+	return (options_number(oo, options_find_code(name)));
+}
+
 struct options_entry *
 options_set_data(
     struct options *oo, const char *name, void *value, void (*freefn)(void *))
 {
 	struct options_entry	*o;
 
-	if ((o = options_find1(oo, name)) == NULL) {
-		o = xmalloc(sizeof *o);
-		o->name = xstrdup(name);
-		SPLAY_INSERT(options_tree, &oo->tree, o);
-	} else if (o->type == OPTIONS_STRING)
-		xfree(o->str);
-	else if (o->type == OPTIONS_DATA)
-		o->freefn(o->data);
+	o = options_add(oo, options_find_code(name));
 
 	o->type = OPTIONS_DATA;
 	o->data = value;
@@ -189,13 +292,19 @@ options_set_data(
 }
 
 void *
-options_get_data(struct options *oo, const char *name)
+options_data(struct options *oo, enum options_code code)
 {
 	struct options_entry	*o;
 
-	if ((o = options_find(oo, name)) == NULL)
+	if ((o = options_lookup(oo, code)) == NULL)
 		fatalx("missing option");
 	if (o->type != OPTIONS_DATA)
 		fatalx("option not data");
 	return (o->data);
 }
+
+void *
+options_get_data(struct options *oo, const char *name)
+{
+	return (options_data(oo, options_find_code(name)));
+}
@@ -75,7 +75,7 @@ recalculate_sizes(void)
 		}
 		s->flags &= ~SESSION_UNATTACHED;
 
-		if (options_get_number(&s->options, "status")) {
+		if (options_number(&s->options, OPTC_STATUS)) {
 			if (ssy == 0)
 				ssy = 1;
 			else
@@ -95,7 +95,7 @@ recalculate_sizes(void)
 		w = ARRAY_ITEM(&windows, i);
 		if (w == NULL)
 			continue;
-		flag = options_get_number(&w->options, "aggressive-resize");
+		flag = options_number(&w->options, OPTC_AGGRESSIVE_RESIZE);
 
 		ssx = ssy = UINT_MAX;
 		for (j = 0; j < ARRAY_LENGTH(&sessions); j++) {
@@ -119,10 +119,10 @@ recalculate_sizes(void)
 		}
 		w->flags &= ~WINDOW_HIDDEN;
 
-		limit = options_get_number(&w->options, "force-width");
+		limit = options_number(&w->options, OPTC_FORCE_WIDTH);
 		if (limit != 0 && ssx > limit)
 			ssx = limit;
-		limit = options_get_number(&w->options, "force-height");
+		limit = options_number(&w->options, OPTC_FORCE_HEIGHT);
 		if (limit != 0 && ssy > limit)
 			ssy = limit;
 
@@ -170,9 +170,10 @@ screen_redraw_screen(struct client *c, int status_only, int borders_only)
 	struct window		*w = c->session->curw->window;
 	struct tty		*tty = &c->tty;
 	struct window_pane	*wp;
-	struct grid_cell	 active_gc, other_gc;
+	struct grid_cell	 active_gc, other_gc, *gc;
 	u_int		 	 i, j, type;
-	int		 	 status, fg, bg;
+	const struct session_cache *sc = session_cache(c->session);
+	int		 	 status;
 	const u_char		*base, *ptr;
 	u_char		       	 ch, border[20];
 
@@ -180,7 +181,7 @@ screen_redraw_screen(struct client *c, int status_only, int borders_only)
 	if (c->message_string != NULL || c->prompt_string != NULL)
 		status = 1;
 	else
-		status = options_get_number(&c->session->options, "status");
+		status = sc->status;
 
 	/* If only drawing status and it is present, don't need the rest. */
 	if (status_only && status) {
@@ -190,17 +191,8 @@ screen_redraw_screen(struct client *c, int status_only, int borders_only)
 	}
 
 	/* Set up pane border attributes. */
-	memcpy(&other_gc, &grid_default_cell, sizeof other_gc);
-	memcpy(&active_gc, &grid_default_cell, sizeof active_gc);
-	active_gc.data = other_gc.data = 'x'; /* not space */
-	fg = options_get_number(&c->session->options, "pane-border-fg");
-	colour_set_fg(&other_gc, fg);
-	bg = options_get_number(&c->session->options, "pane-border-bg");
-	colour_set_bg(&other_gc, bg);
-	fg = options_get_number(&c->session->options, "pane-active-border-fg");
-	colour_set_fg(&active_gc, fg);
-	bg = options_get_number(&c->session->options, "pane-active-border-bg");
-	colour_set_bg(&active_gc, bg);
+	memcpy(&other_gc, &sc->border_gc, sizeof other_gc);
+	memcpy(&active_gc, &sc->active_border_gc, sizeof active_gc);
 
 	/* Draw background and borders. */
 	strlcpy(border, " |-....--||+.", sizeof border);
@@ -221,9 +213,13 @@ screen_redraw_screen(struct client *c, int status_only, int borders_only)
 			if (type == CELL_INSIDE)
 				continue;
 			if (screen_redraw_cell_border1(w->active, i, j) == 1)
-				tty_attributes(tty, &active_gc);
+				gc = &active_gc;
 			else
-				tty_attributes(tty, &other_gc);
+				gc = &other_gc;
+			gc->data = border[type];
+			if (tty_frame_same(tty, i, j, gc, NULL))
+				continue;
+			tty_attributes(tty, gc);
 			tty_cursor(tty, i, j);
 			tty_putc(tty, border[type]);
 		}
@@ -268,8 +264,7 @@ void
 screen_redraw_draw_number(struct client *c, struct window_pane *wp)
 {
 	struct tty		*tty = &c->tty;
-	struct session		*s = c->session;
-	struct options	        *oo = &s->options;
+	const struct session_cache *sc = session_cache(c->session);
 	struct window		*w = wp->window;
 	struct grid_cell	 gc;
 	u_int			 idx, px, py, i, j, xoff, yoff;
@@ -282,8 +277,8 @@ screen_redraw_draw_number(struct client *c, struct window_pane *wp)
 
 	if (wp->sx < len)
 		return;
-	colour = options_get_number(oo, "display-panes-colour");
-	active_colour = options_get_number(oo, "display-panes-active-colour");
+	colour = sc->display_panes_colour;
+	active_colour = sc->display_panes_active_colour;
 
 	px = wp->sx / 2; py = wp->sy / 2;
 	xoff = wp->xoff; yoff = wp->yoff;
@@ -297,7 +292,8 @@ screen_redraw_draw_number(struct client *c, struct window_pane *wp)
 		else
 			colour_set_fg(&gc, colour);
 		tty_attributes(tty, &gc);
-		tty_puts(tty, buf);
+		for (ptr = buf; *ptr != '\0'; ptr++)
+			tty_putc(tty, *ptr);
 		return;
 	}
 
@@ -26,6 +26,7 @@ void	screen_write_initctx(struct screen_write_ctx *, struct tty_ctx *, int);
 void	screen_write_overwrite(struct screen_write_ctx *);
 int	screen_write_combine(
 	    struct screen_write_ctx *, const struct utf8_data *);
+int	screen_write_plain(struct screen_write_ctx *, u_int);
 
 /* Initialise writing with a window. */
 void
@@ -37,13 +38,40 @@ screen_write_start(
 		ctx->s = wp->screen;
 	else
 		ctx->s = s;
+
+	ctx->scrolled = 0;
 }
 
 /* Finish writing. */
-/* ARGSUSED */
 void
-screen_write_stop(unused struct screen_write_ctx *ctx)
+screen_write_stop(struct screen_write_ctx *ctx)
+{
+	screen_write_flush(ctx);
+}
+
+/*
+ * Apply any linefeeds saved up at the bottom of the scroll region, as one
+ * scroll of the grid and one of the terminal. This must be done before
+ * anything else which looks at or changes the grid or the region.
+ */
+void
+screen_write_flush(struct screen_write_ctx *ctx)
 {
+	struct screen	*s = ctx->s;
+	struct tty_ctx	 ttyctx;
+
+	if (ctx->scrolled == 0)
+		return;
+
+	screen_write_initctx(ctx, &ttyctx, 0);
+	ttyctx.ocy = s->rlower;
+
+	grid_view_scroll_region_up(
+	    s->grid, s->rupper, s->rlower, ctx->scrolled);
+
+	ttyctx.num = ctx->scrolled;
+	ctx->scrolled = 0;
+	tty_write(tty_cmd_scrollup, &ttyctx);
 }
 
 /* Write character. */
@@ -351,7 +379,7 @@ screen_write_copy(struct screen_write_ctx *ctx,
 {
 	struct screen		*s = ctx->s;
 	struct grid		*gd = src->grid;
-	struct grid_line	*gl;
+	const struct grid_line	*gl;
 	const struct grid_cell	*gc;
 	const struct grid_utf8	*gu;
 	struct utf8_data	 utf8data;
@@ -360,8 +388,9 @@ screen_write_copy(struct screen_write_ctx *ctx,
 	cx = s->cx;
 	cy = s->cy;
 	for (yy = py; yy < py + ny; yy++) {
-		gl = &gd->linedata[yy];
 		if (yy < gd->hsize + gd->sy) {
+			gl = grid_peek_line(gd, yy);
+
 			/*
 			 * Find start and end position and copy between
 			 * them. Limit to the real end of the line then use a
@@ -381,13 +410,13 @@ screen_write_copy(struct screen_write_ctx *ctx,
 				if (xx >= gl->cellsize)
 					gc = &grid_default_cell;
 				else
-					gc = &gl->celldata[xx];
+					gc = grid_peek_cell(gd, xx, yy);
 				if (!(gc->flags & GRID_FLAG_UTF8)) {
 					screen_write_cell(ctx, gc, NULL);
 					continue;
 				}
 				/* Reinject the UTF-8 sequence. */
-				gu = &gl->utf8data[xx];
+				gu = grid_peek_utf8(gd, xx, yy);
 				utf8data.size = grid_utf8_copy(
 				    gu, utf8data.data, sizeof utf8data.data);
 				utf8data.width = gu->width;
@@ -427,14 +456,16 @@ screen_write_initctx(
 	/* Save the last cell on the screen. */
 	gc = &grid_default_cell;
 	for (xx = 1; xx <= screen_size_x(s); xx++) {
-		gc = grid_view_peek_cell(gd, screen_size_x(s) - xx, s->cy);
+		gc = grid_peek_cell_unchecked(
+		    gd, screen_size_x(s) - xx, gd->hsize + s->cy);
 		if (!(gc->flags & GRID_FLAG_PADDING))
 			break;
 	}
 	ttyctx->last_width = xx;
 	memcpy(&ttyctx->last_cell, gc, sizeof ttyctx->last_cell);
 	if (gc->flags & GRID_FLAG_UTF8) {
-		gu = grid_view_peek_utf8(gd, screen_size_x(s) - xx, s->cy);
+		gu = grid_peek_utf8_unchecked(
+		    gd, screen_size_x(s) - xx, gd->hsize + s->cy);
 		memcpy(&ttyctx->last_utf8, gu, sizeof ttyctx->last_utf8);
 	}
 }
@@ -526,12 +557,14 @@ void
 screen_write_backspace(struct screen_write_ctx *ctx)
 {
 	struct screen		*s = ctx->s;
-	struct grid_line	*gl;
+	const struct grid_line	*gl;
+
+	screen_write_flush(ctx);
 
 	if (s->cx == 0) {
 		if (s->cy == 0)
 			return;
-		gl = &s->grid->linedata[s->grid->hsize + s->cy - 1];
+		gl = grid_peek_line(s->grid, s->grid->hsize + s->cy - 1);
 		if (gl->flags & GRID_LINE_WRAPPED) {
 			s->cy--;
 			s->cx = screen_size_x(s) - 1;
@@ -549,6 +582,8 @@ screen_write_alignmenttest(struct screen_write_ctx *ctx)
 	struct grid_cell       	 gc;
 	u_int			 xx, yy;
 
+	screen_write_flush(ctx);
+
 	screen_write_initctx(ctx, &ttyctx, 0);
 
 	memcpy(&gc, &grid_default_cell, sizeof gc);
@@ -576,6 +611,8 @@ screen_write_insertcharacter(struct screen_write_ctx *ctx, u_int nx)
 	struct screen	*s = ctx->s;
 	struct tty_ctx	 ttyctx;
 
+	screen_write_flush(ctx);
+
 	if (nx == 0)
 		nx = 1;
 
@@ -600,6 +637,8 @@ screen_write_deletecharacter(struct screen_write_ctx *ctx, u_int nx)
 	struct screen	*s = ctx->s;
 	struct tty_ctx	 ttyctx;
 
+	screen_write_flush(ctx);
+
 	if (nx == 0)
 		nx = 1;
 
@@ -624,6 +663,8 @@ screen_write_insertline(struct screen_write_ctx *ctx, u_int ny)
 	struct screen	*s = ctx->s;
 	struct tty_ctx	 ttyctx;
 
+	screen_write_flush(ctx);
+
 	if (ny == 0)
 		ny = 1;
 
@@ -665,6 +706,8 @@ screen_write_deleteline(struct screen_write_ctx *ctx, u_int ny)
 	struct screen	*s = ctx->s;
 	struct tty_ctx	 ttyctx;
 
+	screen_write_flush(ctx);
+
 	if (ny == 0)
 		ny = 1;
 
@@ -706,6 +749,8 @@ screen_write_clearline(struct screen_write_ctx *ctx)
 	struct screen	*s = ctx->s;
 	struct tty_ctx	 ttyctx;
 
+	screen_write_flush(ctx);
+
 	screen_write_initctx(ctx, &ttyctx, 0);
 
 	grid_view_clear(s->grid, 0, s->cy, screen_size_x(s), 1);
@@ -721,6 +766,8 @@ screen_write_clearendofline(struct screen_write_ctx *ctx)
 	struct tty_ctx	 ttyctx;
 	u_int		 sx;
 
+	screen_write_flush(ctx);
+
 	screen_write_initctx(ctx, &ttyctx, 0);
 
 	sx = screen_size_x(s);
@@ -739,6 +786,8 @@ screen_write_clearstartofline(struct screen_write_ctx *ctx)
 	struct tty_ctx	 ttyctx;
 	u_int		 sx;
 
+	screen_write_flush(ctx);
+
 	screen_write_initctx(ctx, &ttyctx, 0);
 
 	sx = screen_size_x(s);
@@ -785,6 +834,8 @@ screen_write_reverseindex(struct screen_write_ctx *ctx)
 	struct screen	*s = ctx->s;
 	struct tty_ctx	 ttyctx;
 
+	screen_write_flush(ctx);
+
 	screen_write_initctx(ctx, &ttyctx, 0);
 
 	if (s->cy == s->rupper)
@@ -802,6 +853,8 @@ screen_write_scrollregion(
 {
 	struct screen	*s = ctx->s;
 
+	screen_write_flush(ctx);
+
 	if (rupper > screen_size_y(s) - 1)
 		rupper = screen_size_y(s) - 1;
 	if (rlower > screen_size_y(s) - 1)
@@ -849,16 +902,30 @@ screen_write_linefeed(struct screen_write_ctx *ctx, int wrapped)
 	struct grid_line	*gl;
 	struct tty_ctx	 	 ttyctx;
 
+	/*
+	 * Save up linefeeds at the bottom of the region until something else
+	 * is written. The first clears the wrapped flag on the current line;
+	 * the rest would clear it on new lines where it is not set anyway.
+	 */
+	if (s->cy == s->rlower && !wrapped) {
+		if (ctx->scrolled++ == 0) {
+			gl = grid_get_line(s->grid, s->grid->hsize + s->cy);
+			gl->flags &= ~GRID_LINE_WRAPPED;
+		}
+		return;
+	}
+	screen_write_flush(ctx);
+
 	screen_write_initctx(ctx, &ttyctx, 0);
 
-	gl = &s->grid->linedata[s->grid->hsize + s->cy];
+	gl = grid_get_line(s->grid, s->grid->hsize + s->cy);
 	if (wrapped)
 		gl->flags |= GRID_LINE_WRAPPED;
 	else
 		gl->flags &= ~GRID_LINE_WRAPPED;
 
 	if (s->cy == s->rlower)
-		grid_view_scroll_region_up(s->grid, s->rupper, s->rlower);
+		grid_view_scroll_region_up(s->grid, s->rupper, s->rlower, 1);
 	else if (s->cy < screen_size_y(s) - 1)
 		s->cy++;
 
@@ -907,6 +974,8 @@ screen_write_clearendofscreen(struct screen_write_ctx *ctx)
 	struct tty_ctx	 ttyctx;
 	u_int		 sx, sy;
 
+	screen_write_flush(ctx);
+
 	screen_write_initctx(ctx, &ttyctx, 0);
 
 	sx = screen_size_x(s);
@@ -927,6 +996,8 @@ screen_write_clearstartofscreen(struct screen_write_ctx *ctx)
 	struct tty_ctx	 ttyctx;
 	u_int		 sx;
 
+	screen_write_flush(ctx);
+
 	screen_write_initctx(ctx, &ttyctx, 0);
 
 	sx = screen_size_x(s);
@@ -948,6 +1019,8 @@ screen_write_clearscreen(struct screen_write_ctx *ctx)
 	struct screen	*s = ctx->s;
 	struct tty_ctx	 ttyctx;
 
+	screen_write_flush(ctx);
+
 	screen_write_initctx(ctx, &ttyctx, 0);
 
 	grid_view_clear(s->grid, 0, 0, screen_size_x(s), screen_size_y(s));
@@ -968,6 +1041,8 @@ screen_write_cell(struct screen_write_ctx *ctx,
 	struct grid_cell 	 tmp_gc, *tmp_gcp;
 	int			 insert = 0;
 
+	screen_write_flush(ctx);
+
 	/* Ignore padding. */
 	if (gc->flags & GRID_FLAG_PADDING)
 		return;
@@ -1032,11 +1107,11 @@ screen_write_cell(struct screen_write_ctx *ctx,
 	}
 
 	/* Set the cell. */
-	grid_view_set_cell(gd, s->cx, s->cy, gc);
+	grid_set_cell_unchecked(gd, s->cx, gd->hsize + s->cy, gc);
 	if (gc->flags & GRID_FLAG_UTF8) {
 		/* Construct UTF-8 and write it. */
 		grid_utf8_set(&gu, utf8data);
-		grid_view_set_utf8(gd, s->cx, s->cy, &gu);
+		grid_set_utf8_unchecked(gd, s->cx, gd->hsize + s->cy, &gu);
 	}
 
 	/* Move the cursor. */
@@ -1063,6 +1138,96 @@ screen_write_cell(struct screen_write_ctx *ctx,
 	}
 }
 
+/*
+ * Write a run of n narrow characters with the same attributes. This does the
+ * same as writing each with screen_write_cell, but a line at a time, with one
+ * tty command for each line.
+ */
+void
+screen_write_cells(struct screen_write_ctx *ctx,
+    const struct grid_cell *gc, const u_char *buf, u_int n)
+{
+	struct screen		*s = ctx->s;
+	struct grid		*gd = s->grid;
+	struct tty_ctx		 ttyctx;
+	struct grid_cell	 tmp_gc;
+	u_int			 nx;
+
+	screen_write_flush(ctx);
+
+	/*
+	 * Insert mode and selections are per cell, so leave those to
+	 * screen_write_cell.
+	 */
+	if (s->mode & MODE_INSERT || s->sel.flag ||
+	    gc->flags & (GRID_FLAG_UTF8|GRID_FLAG_PADDING)) {
+		memcpy(&tmp_gc, gc, sizeof tmp_gc);
+		for (; n > 0; n--) {
+			tmp_gc.data = *buf++;
+			screen_write_cell(ctx, &tmp_gc, NULL);
+		}
+		return;
+	}
+
+	while (n > 0) {
+		/*
+		 * If the cursor is at the end of the line or any UTF-8
+		 * characters are being overwritten, write the first cell on its
+		 * own to wrap or clean up properly.
+		 */
+		nx = 0;
+		if (s->cx < screen_size_x(s) && s->cy < screen_size_y(s)) {
+			nx = screen_size_x(s) - s->cx;
+			if (nx > n)
+				nx = n;
+		}
+		if (nx == 0 || !screen_write_plain(ctx, nx)) {
+			memcpy(&tmp_gc, gc, sizeof tmp_gc);
+			tmp_gc.data = *buf++;
+			screen_write_cell(ctx, &tmp_gc, NULL);
+			n--;
+			continue;
+		}
+
+		/*
+		 * The last cell is not needed: the cursor is not at the end of
+		 * the line or after a wide character there.
+		 */
+		screen_write_initctx(ctx, &ttyctx, 0);
+
+		grid_set_cells_unchecked(
+		    gd, s->cx, gd->hsize + s->cy, gc, buf, nx);
+		s->cx += nx;
+
+		ttyctx.cell = gc;
+		ttyctx.ptr = (void *) buf;
+		ttyctx.num = nx;
+		tty_write(tty_cmd_cells, &ttyctx);
+
+		buf += nx;
+		n -= nx;
+	}
+}
+
+/* Check if the nx cells at the cursor are free of UTF-8 and padding. */
+int
+screen_write_plain(struct screen_write_ctx *ctx, u_int nx)
+{
+	struct screen		*s = ctx->s;
+	struct grid		*gd = s->grid;
+	const struct grid_line	*gl;
+	u_int			 xx;
+
+	gl = grid_peek_line(gd, gd->hsize + s->cy);
+	if (gl->rundata != NULL)
+		return (0);
+	for (xx = s->cx; xx < s->cx + nx && xx < gl->cellsize; xx++) {
+		if (gl->celldata[xx].flags & (GRID_FLAG_UTF8|GRID_FLAG_PADDING))
+			return (0);
+	}
+	return (1);
+}
+
 /* Combine a UTF-8 zero-width character onto the previous. */
 int
 screen_write_combine(
@@ -1130,7 +1295,7 @@ screen_write_overwrite(struct screen_write_ctx *ctx)
 	const struct grid_utf8	*gu;
 	u_int			 xx;
 
-	gc = grid_view_peek_cell(gd, s->cx, s->cy);
+	gc = grid_peek_cell_unchecked(gd, s->cx, gd->hsize + s->cy);
 	if (gc->flags & GRID_FLAG_PADDING) {
 		/*
 		 * A padding cell, so clear any following and leading padding
@@ -183,7 +183,7 @@ screen_resize_y(struct screen *s, u_int sy)
 		 */
 		available = s->cy;
 		if (gd->flags & GRID_HISTORY)
-			gd->hsize += needed;
+			grid_grow_history(gd, needed);
 		else if (needed > 0 && available > 0) {
 			if (available > needed)
 				available = needed;
@@ -193,8 +193,7 @@ screen_resize_y(struct screen *s, u_int sy)
 	}
 
 	/* Resize line arrays. */
-	gd->linedata = xrealloc(
-	    gd->linedata, gd->hsize + sy, sizeof *gd->linedata);
+	grid_reserve_lines(gd, gd->hsize + sy);
 
 	/* Size increasing. */
 	if (sy > oldy) {
@@ -208,7 +207,7 @@ screen_resize_y(struct screen *s, u_int sy)
 		if (gd->flags & GRID_HISTORY && available > 0) {
 			if (available > needed)
 				available = needed;
-			gd->hsize -= available;
+			grid_shrink_history(gd, available);
 			s->cy += available;
 		} else
 			available = 0;
@@ -216,7 +215,7 @@ screen_resize_y(struct screen *s, u_int sy)
 
 		/* Then fill the rest in with blanks. */
 		for (i = gd->hsize + sy - needed; i < gd->hsize + sy; i++)
-			memset(&gd->linedata[i], 0, sizeof gd->linedata[i]);
+			memset(grid_ring_line(gd, i), 0, sizeof *gd->linedata);
 	}
 
 	/* Set the new size, and reset the scroll region. */
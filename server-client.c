@@ -28,6 +28,9 @@
 
 void	server_client_handle_key(int, struct mouse_event *, void *);
 void	server_client_repeat_timer(int, short, void *);
+void	server_client_render_timer(int, short, void *);
+void	server_client_check_backoff(struct client *);
+void	server_client_check_shared(struct client *);
 void	server_client_check_redraw(struct client *);
 void	server_client_set_title(struct client *);
 void	server_client_reset_state(struct client *);
@@ -86,6 +89,7 @@ server_client_create(int fd)
 	c->prompt_index = 0;
 
 	evtimer_set(&c->repeat_timer, server_client_repeat_timer, c);
+	evtimer_set(&c->render_timer, server_client_render_timer, c);
 
 	for (i = 0; i < ARRAY_LENGTH(&clients); i++) {
 		if (ARRAY_ITEM(&clients, i) == NULL) {
@@ -124,6 +128,7 @@ server_client_lost(struct client *c)
 		xfree(c->title);
 
 	evtimer_del(&c->repeat_timer);
+	evtimer_del(&c->render_timer);
 
 	evtimer_del(&c->identify_timer);
 
@@ -199,13 +204,14 @@ client_lost:
 void
 server_client_status_timer(void)
 {
-	struct client	*c;
-	struct session	*s;
-	struct job	*job;
-	struct timeval	 tv;
-	u_int		 i;
-	int		 interval;
-	time_t		 difference;
+	struct client			*c;
+	struct session			*s;
+	const struct session_cache	*sc;
+	struct job			*job;
+	struct timeval			 tv;
+	u_int				 i;
+	int				 interval;
+	time_t				 difference;
 
 	if (gettimeofday(&tv, NULL) != 0)
 		fatal("gettimeofday failed");
@@ -223,10 +229,11 @@ server_client_status_timer(void)
 			continue;
 		}
 		s = c->session;
+		sc = session_cache(s);
 
-		if (!options_get_number(&s->options, "status"))
+		if (!sc->status)
 			continue;
-		interval = options_get_number(&s->options, "status-interval");
+		interval = sc->status_interval;
 
 		difference = tv.tv_sec - c->status_timer.tv_sec;
 		if (difference >= interval) {
@@ -245,7 +252,7 @@ server_client_handle_key(int key, struct mouse_event *mouse, void *data)
 	struct session		*s;
 	struct window		*w;
 	struct window_pane	*wp;
-	struct options		*oo;
+	const struct session_cache *sc;
 	struct timeval		 tv;
 	struct key_binding	*bd;
 	struct keylist		*keylist;
@@ -266,7 +273,7 @@ server_client_handle_key(int key, struct mouse_event *mouse, void *data)
 
 	w = c->session->curw->window;
 	wp = w->active;
-	oo = &c->session->options;
+	sc = session_cache(c->session);
 
 	/* Special case: number keys jump to pane in identify mode. */
 	if (c->flags & CLIENT_IDENTIFY && key >= '0' && key <= '9') {
@@ -294,7 +301,7 @@ server_client_handle_key(int key, struct mouse_event *mouse, void *data)
 	if (key == KEYC_MOUSE) {
 		if (c->flags & CLIENT_READONLY)
 			return;
-		if (options_get_number(oo, "mouse-select-pane")) {
+		if (sc->mouse_select_pane) {
 			window_set_active_at(w, mouse->x, mouse->y);
 			server_redraw_window_borders(w);
 			wp = w->active;
@@ -304,7 +311,7 @@ server_client_handle_key(int key, struct mouse_event *mouse, void *data)
 	}
 
 	/* Is this a prefix key? */
-	keylist = options_get_data(&c->session->options, "prefix");
+	keylist = options_data(&c->session->options, OPTC_PREFIX);
 	isprefix = 0;
 	for (i = 0; i < ARRAY_LENGTH(keylist); i++) {
 		if (key == ARRAY_ITEM(keylist, i)) {
@@ -353,7 +360,7 @@ server_client_handle_key(int key, struct mouse_event *mouse, void *data)
 	}
 
 	/* If this key can repeat, reset the repeat flags and timer. */
-	xtimeout = options_get_number(&c->session->options, "repeat-time");
+	xtimeout = sc->repeat_time;
 	if (xtimeout != 0 && bd->can_repeat) {
 		c->flags |= CLIENT_PREFIX|CLIENT_REPEAT;
 
@@ -374,15 +381,19 @@ server_client_loop(void)
 	struct client		*c;
 	struct window		*w;
 	struct window_pane	*wp;
-	u_int		 	 i;
+	struct timeval		 tv;
+	u_int		 	 i, interval;
 
 	for (i = 0; i < ARRAY_LENGTH(&clients); i++) {
 		c = ARRAY_ITEM(&clients, i);
 		if (c == NULL || c->session == NULL)
 			continue;
 
+		server_client_check_backoff(c);
 		server_client_check_redraw(c);
-		server_client_reset_state(c);
+		if (!(c->flags & CLIENT_RENDERWAIT))
+			server_client_reset_state(c);
+		server_client_check_shared(c);
 	}
 
 	/*
@@ -398,6 +409,28 @@ server_client_loop(void)
 		TAILQ_FOREACH(wp, &w->panes, entry)
 			wp->flags &= ~PANE_REDRAW;
 	}
+
+	/*
+	 * Pass on everything written to each client in this loop. With
+	 * render-interval set, a client that has been sent a frame is sent no
+	 * more pane updates until the interval has passed.
+	 */
+	interval = options_number(&global_options, OPTC_RENDER_INTERVAL);
+	for (i = 0; i < ARRAY_LENGTH(&clients); i++) {
+		c = ARRAY_ITEM(&clients, i);
+		if (c == NULL)
+			continue;
+
+		if (interval != 0 && c->tty.olen != 0 &&
+		    !(c->flags & CLIENT_RENDERWAIT)) {
+			tv.tv_sec = interval / 1000;
+			tv.tv_usec = (interval % 1000) * 1000L;
+			evtimer_add(&c->render_timer, &tv);
+			c->flags |= CLIENT_RENDERWAIT;
+		}
+		tty_flush(&c->tty);
+		server_client_check_backoff(c);
+	}
 }
 
 /*
@@ -415,12 +448,12 @@ server_client_reset_state(struct client *c)
 	struct window		*w = c->session->curw->window;
 	struct window_pane	*wp = w->active;
 	struct screen		*s = wp->screen;
-	struct options		*oo = &c->session->options;
+	const struct session_cache *sc = session_cache(c->session);
 	int			 status, mode;
 
 	tty_region(&c->tty, 0, c->tty.sy - 1);
 
-	status = options_get_number(oo, "status");
+	status = sc->status;
 	if (!window_pane_visible(wp) || wp->yoff + s->cy >= c->tty.sy - status)
 		tty_cursor(&c->tty, 0, 0);
 	else
@@ -428,7 +461,7 @@ server_client_reset_state(struct client *c)
 
 	mode = s->mode;
 	if (TAILQ_NEXT(TAILQ_FIRST(&w->panes), entry) != NULL &&
-	    options_get_number(oo, "mouse-select-pane"))
+	    sc->mouse_select_pane)
 		mode |= MODE_MOUSE;
 	tty_update_mode(&c->tty, mode);
 	tty_reset(&c->tty);
@@ -445,19 +478,82 @@ server_client_repeat_timer(unused int fd, unused short events, void *data)
 		c->flags &= ~(CLIENT_PREFIX|CLIENT_REPEAT);
 }
 
+/*
+ * Stop sending pane updates to a client which has more output waiting than
+ * it can take, and start again once it has all been written. The panes keep
+ * being read, so one slow client does not hold up the others.
+ */
+void
+server_client_check_backoff(struct client *c)
+{
+	size_t	queued;
+
+	if (!(c->tty.flags & TTY_OPENED))
+		return;
+
+	queued = EVBUFFER_LENGTH(c->tty.event->output);
+	if (c->flags & CLIENT_BACKOFF) {
+		if (queued == 0)
+			c->flags &= ~CLIENT_BACKOFF;
+	} else if (queued > BACKOFF_THRESHOLD)
+		c->flags |= CLIENT_BACKOFF;
+}
+
+/*
+ * Share the copy of the terminal with an earlier client of the same type
+ * attached to the same session, if both now show the same. Updates can then
+ * be encoded once for both by tty_write. Nothing can have changed unless one
+ * of them has been written to since last time.
+ */
+void
+server_client_check_shared(struct client *c)
+{
+	struct client	*c2;
+	u_int		 i;
+
+	if (c->flags & (CLIENT_SUSPENDED|CLIENT_DEAD))
+		return;
+
+	for (i = 0; i < ARRAY_LENGTH(&clients); i++) {
+		c2 = ARRAY_ITEM(&clients, i);
+		if (c2 == c)
+			break;
+		if (c2 == NULL || c2->session != c->session)
+			continue;
+		if (c2->flags & (CLIENT_SUSPENDED|CLIENT_DEAD))
+			continue;
+		if (c->tty.olen == 0 && c2->tty.olen == 0)
+			continue;
+
+		if (c->tty.term == c2->tty.term &&
+		    tty_frame_join(&c->tty, &c2->tty))
+			break;
+	}
+}
+
+/* Render time callback. */
+/* ARGSUSED */
+void
+server_client_render_timer(unused int fd, unused short events, void *data)
+{
+	struct client	*c = data;
+
+	c->flags &= ~CLIENT_RENDERWAIT;
+}
+
 /* Check for client redraws. */
 void
 server_client_check_redraw(struct client *c)
 {
 	struct session		*s = c->session;
 	struct window_pane	*wp;
-	int		 	 flags, redraw;
+	int		 	 flags, redraw, damaged;
 
 	flags = c->tty.flags & TTY_FREEZE;
 	c->tty.flags &= ~TTY_FREEZE;
 
 	if (c->flags & (CLIENT_REDRAW|CLIENT_STATUS)) {
-		if (options_get_number(&s->options, "set-titles"))
+		if (session_cache(s)->set_titles)
 			server_client_set_title(c);
 
 		if (c->message_string != NULL)
@@ -470,12 +566,24 @@ server_client_check_redraw(struct client *c)
 			c->flags &= ~CLIENT_STATUS;
 	}
 
+	/*
+	 * Updates held back by render-interval are drawn once it has passed.
+	 * The copy of the terminal means only cells which changed are sent.
+	 */
+	damaged = 0;
+	if ((c->flags & (CLIENT_DAMAGED|CLIENT_RENDERWAIT|CLIENT_BACKOFF)) ==
+	    CLIENT_DAMAGED) {
+		c->flags &= ~CLIENT_DAMAGED;
+		damaged = 1;
+	}
+
 	if (c->flags & CLIENT_REDRAW) {
 		screen_redraw_screen(c, 0, 0);
-		c->flags &= ~(CLIENT_STATUS|CLIENT_BORDERS);
+		c->flags &= ~(CLIENT_STATUS|CLIENT_BORDERS|CLIENT_DAMAGED);
 	} else {
 		TAILQ_FOREACH(wp, &c->session->curw->window->panes, entry) {
-			if (wp->flags & PANE_REDRAW)
+			if (wp->flags & PANE_REDRAW ||
+			    (damaged && window_pane_visible(wp)))
 				screen_redraw_pane(c, wp);
 		}
 	}
@@ -499,7 +607,7 @@ server_client_set_title(struct client *c)
 	const char	*template;
 	char		*title;
 
-	template = options_get_string(&s->options, "set-titles-string");
+	template = options_string(&s->options, OPTC_SET_TITLES_STRING);
 
 	title = status_replace(c, NULL, template, time(NULL), 1);
 	if (c->title == NULL || strcmp(title, c->title) != 0) {
@@ -651,7 +759,7 @@ server_client_msg_info(struct cmd_ctx *ctx, const char *fmt, ...)
 	struct msg_print_data	data;
 	va_list			ap;
 
-	if (options_get_number(&global_options, "quiet"))
+	if (options_number(&global_options, OPTC_QUIET))
 		return;
 
 	va_start(ap, fmt);
@@ -743,7 +851,7 @@ server_client_msg_shell(struct client *c)
 	struct msg_shell_data	 data;
 	const char		*shell;
 
-	shell = options_get_string(&global_s_options, "default-shell");
+	shell = options_string(&global_s_options, OPTC_DEFAULT_SHELL);
 
 	if (*shell == '\0' || areshell(shell))
 		shell = _PATH_BSHELL;
@@ -38,7 +38,7 @@ server_fill_environ(struct session *s, struct environ *env)
 	    "%s,%ld,%u", socket_path, (long) getpid(), idx);
 	environ_set(env, "TMUX", tmuxvar);
 
-	term = options_get_string(&s->options, "default-terminal");
+	term = options_string(&s->options, OPTC_DEFAULT_TERMINAL);
 	environ_set(env, "TERM", term);
 }
 
@@ -236,7 +236,7 @@ server_lock_client(struct client *c)
 	if (c->flags & CLIENT_SUSPENDED)
 		return;
 
-	cmd = options_get_string(&c->session->options, "lock-command");
+	cmd = options_string(&c->session->options, OPTC_LOCK_COMMAND);
 	cmdlen = strlcpy(lockdata.cmd, cmd, sizeof lockdata.cmd);
 	if (cmdlen >= sizeof lockdata.cmd)
 		return;
@@ -308,7 +308,7 @@ server_link_window(struct session *src, struct winlink *srcwl,
 	}
 
 	if (dstidx == -1)
-		dstidx = -1 - options_get_number(&dst->options, "base-index");
+		dstidx = -1 - options_number(&dst->options, OPTC_BASE_INDEX);
 	dstwl = session_attach(dst, srcwl->window, dstidx, cause);
 	if (dstwl == NULL)
 		return (-1);
@@ -334,11 +334,12 @@ server_destroy_pane(struct window_pane *wp)
 {
 	struct window	*w = wp->window;
 
+	window_pane_drain(wp);
 	close(wp->fd);
 	bufferevent_free(wp->event);
 	wp->fd = -1;
 
-	if (options_get_number(&w->options, "remain-on-exit"))
+	if (options_number(&w->options, OPTC_REMAIN_ON_EXIT))
 		return;
 
 	layout_close_pane(wp);
@@ -386,7 +387,7 @@ server_set_identify(struct client *c)
 	struct timeval	tv;
 	int		delay;
 
-	delay = options_get_number(&c->session->options, "display-panes-time");
+	delay = options_number(&c->session->options, OPTC_DISPLAY_PANES_TIME);
 	tv.tv_sec = delay / 1000;
 	tv.tv_usec = (delay % 1000) * 1000L;
 
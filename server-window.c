@@ -23,37 +23,11 @@
 
 #include "tmux.h"
 
-int	server_window_backoff(struct window_pane *);
 int	server_window_check_bell(struct session *, struct window *);
 int	server_window_check_activity(struct session *, struct window *);
 int	server_window_check_content(
 	    struct session *, struct window *, struct window_pane *);
 
-/* Check if this window should suspend reading. */
-int
-server_window_backoff(struct window_pane *wp)
-{
-	struct client	*c;
-	u_int		 i;
-
-	if (!window_pane_visible(wp))
-		return (0);
-
-	for (i = 0; i < ARRAY_LENGTH(&clients); i++) {
-		c = ARRAY_ITEM(&clients, i);
-		if (c == NULL || c->session == NULL)
-			continue;
-		if ((c->flags & (CLIENT_SUSPENDED|CLIENT_DEAD)) != 0)
-			continue;
-		if (c->session->curw->window != wp->window)
-			continue;
-
-		if (EVBUFFER_LENGTH(c->tty.event->output) > BACKOFF_THRESHOLD)
-			return (1);
-	}
-	return (0);
-}
-
 /* Window functions that need to happen every loop. */
 void
 server_window_loop(void)
@@ -63,20 +37,29 @@ server_window_loop(void)
 	struct session		*s;
 	u_int		 	 i, j;
 
+	window_pane_parse_pending();
+
 	for (i = 0; i < ARRAY_LENGTH(&windows); i++) {
 		w = ARRAY_ITEM(&windows, i);
 		if (w == NULL)
 			continue;
 
 		TAILQ_FOREACH(wp, &w->panes, entry) {
-			if (wp->fd == -1)
+			if (wp->fd == -1 || wp->flags & PANE_FREEZE)
 				continue;
-			if (!(wp->flags & PANE_FREEZE)) {
-				if (server_window_backoff(wp))
-					bufferevent_disable(wp->event, EV_READ);
-				else
-					bufferevent_enable(wp->event, EV_READ);
-			}
+
+			/* Output may have been left while the pane was frozen. */
+			if (!(wp->flags & PANE_PENDING) &&
+			    EVBUFFER_LENGTH(wp->event->input) != 0)
+				window_pane_parse(wp);
+			if (wp->flags & PANE_PENDING)
+				continue;
+
+			/*
+			 * Panes are always read; clients which can't keep up
+			 * skip updates instead (see server_client_loop).
+			 */
+			bufferevent_enable(wp->event, EV_READ);
 		}
 
 		for (j = 0; j < ARRAY_LENGTH(&sessions); j++) {
@@ -109,12 +92,12 @@ server_window_check_bell(struct session *s, struct window *w)
 		return (0);
 	session_alert_add(s, w, WINDOW_BELL);
 
-	action = options_get_number(&s->options, "bell-action");
+	action = options_number(&s->options, OPTC_BELL_ACTION);
 	switch (action) {
 	case BELL_ANY:
 		if (s->flags & SESSION_UNATTACHED)
 			break;
-		visual = options_get_number(&s->options, "visual-bell");
+		visual = options_number(&s->options, OPTC_VISUAL_BELL);
 		for (i = 0; i < ARRAY_LENGTH(&clients); i++) {
 			c = ARRAY_ITEM(&clients, i);
 			if (c == NULL || c->session != s)
@@ -134,7 +117,7 @@ server_window_check_bell(struct session *s, struct window *w)
 	case BELL_CURRENT:
 		if (s->flags & SESSION_UNATTACHED)
 			break;
-		visual = options_get_number(&s->options, "visual-bell");
+		visual = options_number(&s->options, OPTC_VISUAL_BELL);
 		for (i = 0; i < ARRAY_LENGTH(&clients); i++) {
 			c = ARRAY_ITEM(&clients, i);
 			if (c == NULL || c->session != s)
@@ -165,7 +148,7 @@ server_window_check_activity(struct session *s, struct window *w)
 	if (s->curw->window == w)
 		return (0);
 
-	if (!options_get_number(&w->options, "monitor-activity"))
+	if (!options_number(&w->options, OPTC_MONITOR_ACTIVITY))
 		return (0);
 
 	if (session_alert_has_window(s, w, WINDOW_ACTIVITY))
@@ -174,7 +157,7 @@ server_window_check_activity(struct session *s, struct window *w)
 
 	if (s->flags & SESSION_UNATTACHED)
 		return (0);
-	if (options_get_number(&s->options, "visual-activity")) {
+	if (options_number(&s->options, OPTC_VISUAL_ACTIVITY)) {
 		for (i = 0; i < ARRAY_LENGTH(&clients); i++) {
 			c = ARRAY_ITEM(&clients, i);
 			if (c == NULL || c->session != s)
@@ -201,7 +184,7 @@ server_window_check_content(
 	if (s->curw->window == w)
 		return (0);
 
-	ptr = options_get_string(&w->options, "monitor-content");
+	ptr = options_string(&w->options, OPTC_MONITOR_CONTENT);
 	if (ptr == NULL || *ptr == '\0')
 		return (0);
 
@@ -215,7 +198,7 @@ server_window_check_content(
 	session_alert_add(s, w, WINDOW_CONTENT);
 	if (s->flags & SESSION_UNATTACHED)
 		return (0);
-	if (options_get_number(&s->options, "visual-content")) {
+	if (options_number(&s->options, OPTC_VISUAL_CONTENT)) {
 		for (i = 0; i < ARRAY_LENGTH(&clients); i++) {
 			c = ARRAY_ITEM(&clients, i);
 			if (c == NULL || c->session != s)
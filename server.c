@@ -41,6 +41,9 @@
  * Main server functions.
  */
 
+/* Lines dropped from a pane's history at once when over the memory budget. */
+#define SERVER_HISTORY_LINES 100
+
 /* Client list. */
 struct clients	 clients;
 struct clients	 dead_clients;
@@ -66,6 +69,9 @@ void		 server_child_stopped(pid_t, int);
 void		 server_second_callback(int, short, void *);
 void		 server_lock_server(void);
 void		 server_lock_sessions(void);
+void		 server_view_panes(void);
+int		 server_history_cmp(const void *, const void *);
+void		 server_collect_history(void);
 
 /* Create server socket. */
 int
@@ -154,7 +160,6 @@ server_start(char *path)
 	TAILQ_INIT(&session_groups);
 	mode_key_init_trees();
 	key_bindings_init();
-	utf8_build();
 
 	start_time = time(NULL);
 	socket_path = path;
@@ -230,7 +235,11 @@ void
 server_loop(void)
 {
 	while (!server_should_shutdown()) {
-		event_loop(EVLOOP_ONCE);
+		/* Don't wait for events if there is pane output left to parse. */
+		if (TAILQ_EMPTY(&pending_panes))
+			event_loop(EVLOOP_ONCE);
+		else
+			event_loop(EVLOOP_NONBLOCK);
 
 		server_window_loop();
 		server_client_loop();
@@ -520,9 +529,9 @@ server_second_callback(unused int fd, unused short events, unused void *arg)
 	struct window		*w;
 	struct window_pane	*wp;
 	struct timeval		 tv;
-	u_int		 	 i;
+	u_int		 	 i, depth, spill;
 
-	if (options_get_number(&global_s_options, "lock-server"))
+	if (options_number(&global_s_options, OPTC_LOCK_SERVER))
 		server_lock_server();
 	else
 		server_lock_sessions();
@@ -532,12 +541,19 @@ server_second_callback(unused int fd, unused short events, unused void *arg)
 		if (w == NULL)
 			continue;
 
+		depth = options_number(&w->options, OPTC_HISTORY_COMPRESS);
+		spill = options_number(&w->options, OPTC_HISTORY_SPILL);
 		TAILQ_FOREACH(wp, &w->panes, entry) {
 			if (wp->mode != NULL && wp->mode->timer != NULL)
 				wp->mode->timer(wp);
+			grid_compress_history(wp->base.grid, depth);
+			grid_spill_history(wp->base.grid, spill);
 		}
 	}
 
+	server_view_panes();
+	server_collect_history();
+
 	server_client_status_timer();
 
 	evtimer_del(&server_ev_second);
@@ -566,7 +582,7 @@ server_lock_server(void)
 			continue;
 		}
 
-		timeout = options_get_number(&s->options, "lock-after-time");
+		timeout = options_number(&s->options, OPTC_LOCK_AFTER_TIME);
 		if (timeout <= 0 || t <= s->activity_time.tv_sec + timeout)
 			return;	/* not timed out */
 	}
@@ -595,10 +611,111 @@ server_lock_sessions(void)
 			continue;
 		}
 
-		timeout = options_get_number(&s->options, "lock-after-time");
+		timeout = options_number(&s->options, OPTC_LOCK_AFTER_TIME);
 		if (timeout > 0 && t > s->activity_time.tv_sec + timeout) {
 			server_lock_session(s);
 			recalculate_sizes();
 		}
 	}
 }
+
+/* Mark the panes in each attached client's current window as viewed. */
+void
+server_view_panes(void)
+{
+	struct client		*c;
+	struct window_pane	*wp;
+	u_int			 i;
+	time_t			 t;
+
+	t = time(NULL);
+	for (i = 0; i < ARRAY_LENGTH(&clients); i++) {
+		c = ARRAY_ITEM(&clients, i);
+		if (c == NULL || c->session == NULL)
+			continue;
+		if (c->flags & CLIENT_SUSPENDED)
+			continue;
+
+		TAILQ_FOREACH(wp, &c->session->curw->window->panes, entry)
+			wp->view_time = t;
+	}
+}
+
+/* Sort panes so the one viewed least recently is first. */
+int
+server_history_cmp(const void *a, const void *b)
+{
+	const struct window_pane	*wpa = *(struct window_pane **) a;
+	const struct window_pane	*wpb = *(struct window_pane **) b;
+
+	if (wpa->view_time < wpb->view_time)
+		return (-1);
+	if (wpa->view_time > wpb->view_time)
+		return (1);
+	return (0);
+}
+
+/*
+ * Keep the history held in memory by all panes under history-memory-budget.
+ * The panes viewed least recently are reduced first: their history is
+ * compressed, then spilled to disk, and the oldest lines are dropped only if it
+ * cannot be spilled. Each pane gets one limited step a second, so this never
+ * takes long.
+ */
+void
+server_collect_history(void)
+{
+	ARRAY_DECL(, struct window_pane *) panes;
+	struct window		*w;
+	struct window_pane	*wp;
+	struct grid		*gd;
+	size_t			 budget, total, size, before;
+	u_int			 i;
+
+	budget = options_number(&global_options, OPTC_HISTORY_MEMORY_BUDGET);
+	if (budget == 0)
+		return;
+	budget *= 1024;
+
+	ARRAY_INIT(&panes);
+	total = 0;
+	for (i = 0; i < ARRAY_LENGTH(&windows); i++) {
+		w = ARRAY_ITEM(&windows, i);
+		if (w == NULL)
+			continue;
+		TAILQ_FOREACH(wp, &w->panes, entry) {
+			total += grid_history_size(wp->base.grid);
+			ARRAY_ADD(&panes, wp);
+		}
+	}
+	if (total <= budget) {
+		ARRAY_FREE(&panes);
+		return;
+	}
+	log_debug("history %zu bytes, budget %zu", total, budget);
+
+	qsort(ARRAY_DATA(&panes), ARRAY_LENGTH(&panes),
+	    sizeof (struct window_pane *), server_history_cmp);
+	for (i = 0; i < ARRAY_LENGTH(&panes) && total > budget; i++) {
+		wp = ARRAY_ITEM(&panes, i);
+		gd = wp->base.grid;
+
+		/* Keep a screen of history as it is, for copy mode. */
+		before = grid_history_size(gd);
+		grid_compress_history(gd, gd->sy);
+		size = grid_history_size(gd);
+		if (size >= before) {
+			grid_spill_history(gd, gd->sy);
+			size = grid_history_size(gd);
+		}
+		/* Dropping lines already on disk would not save anything. */
+		if (size >= before && gd->bspilled == 0 && wp->mode == NULL) {
+			grid_drop_history(gd, SERVER_HISTORY_LINES);
+			size = grid_history_size(gd);
+		}
+		if (size < before)
+			total -= before - size;
+	}
+
+	ARRAY_FREE(&panes);
+}
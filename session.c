@@ -138,6 +138,7 @@ session_create(const char *name, const char *cmd, const char *cwd,
 	paste_init_stack(&s->buffers);
 
 	options_init(&s->options, &global_s_options);
+	s->cache.generation = 0;
 	environ_init(&s->environ);
 	if (env != NULL)
 		environ_copy(env, &s->environ);
@@ -219,6 +220,44 @@ session_destroy(struct session *s)
 	s->flags |= SESSION_DEAD;
 }
 
+/* Get cached session options, refreshing them if any option has changed. */
+const struct session_cache *
+session_cache(struct session *s)
+{
+	struct session_cache	*sc = &s->cache;
+	struct options		*oo = &s->options;
+
+	if (sc->generation == options_generation)
+		return (sc);
+	sc->generation = options_generation;
+
+	sc->status = options_number(oo, OPTC_STATUS);
+	sc->status_interval = options_number(oo, OPTC_STATUS_INTERVAL);
+	sc->set_titles = options_number(oo, OPTC_SET_TITLES);
+	sc->mouse_select_pane = options_number(oo, OPTC_MOUSE_SELECT_PANE);
+	sc->repeat_time = options_number(oo, OPTC_REPEAT_TIME);
+
+	memcpy(&sc->border_gc, &grid_default_cell, sizeof sc->border_gc);
+	memcpy(&sc->active_border_gc, &grid_default_cell,
+	    sizeof sc->active_border_gc);
+	sc->border_gc.data = sc->active_border_gc.data = 'x'; /* not space */
+	colour_set_fg(&sc->border_gc,
+	    options_number(oo, OPTC_PANE_BORDER_FG));
+	colour_set_bg(&sc->border_gc,
+	    options_number(oo, OPTC_PANE_BORDER_BG));
+	colour_set_fg(&sc->active_border_gc,
+	    options_number(oo, OPTC_PANE_ACTIVE_BORDER_FG));
+	colour_set_bg(&sc->active_border_gc,
+	    options_number(oo, OPTC_PANE_ACTIVE_BORDER_BG));
+
+	sc->display_panes_colour =
+	    options_number(oo, OPTC_DISPLAY_PANES_COLOUR);
+	sc->display_panes_active_colour =
+	    options_number(oo, OPTC_DISPLAY_PANES_ACTIVE_COLOUR);
+
+	return (sc);
+}
+
 /* Find session index. */
 int
 session_index(struct session *s, u_int *i)
@@ -245,11 +284,11 @@ session_new(struct session *s,
 	environ_copy(&s->environ, &env);
 	server_fill_environ(s, &env);
 
-	shell = options_get_string(&s->options, "default-shell");
+	shell = options_string(&s->options, OPTC_DEFAULT_SHELL);
 	if (*shell == '\0' || areshell(shell))
 		shell = _PATH_BSHELL;
 
-	hlimit = options_get_number(&s->options, "history-limit");
+	hlimit = options_number(&s->options, OPTC_HISTORY_LIMIT);
 	w = window_create(
 	    name, cmd, shell, cwd, &env, s->tio, s->sx, s->sy, hlimit, cause);
 	if (w == NULL) {
@@ -258,7 +297,7 @@ session_new(struct session *s,
 	}
 	environ_free(&env);
 
-	if (options_get_number(&s->options, "set-remain-on-exit"))
+	if (options_number(&s->options, OPTC_SET_REMAIN_ON_EXIT))
 		options_set_number(&w->options, "remain-on-exit", 1);
 
 	return (session_attach(s, w, idx, cause));
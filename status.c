@@ -55,20 +55,20 @@ status_redraw_get_left(struct client *c,
 	u_char		 fg, bg, attr;
 	size_t		 leftlen;
 
-	fg = options_get_number(&s->options, "status-left-fg");
+	fg = options_number(&s->options, OPTC_STATUS_LEFT_FG);
 	if (fg != 8)
 		colour_set_fg(gc, fg);
-	bg = options_get_number(&s->options, "status-left-bg");
+	bg = options_number(&s->options, OPTC_STATUS_LEFT_BG);
 	if (bg != 8)
 		colour_set_bg(gc, bg);
-	attr = options_get_number(&s->options, "status-left-attr");
+	attr = options_number(&s->options, OPTC_STATUS_LEFT_ATTR);
 	if (attr != 0)
 		gc->attr = attr;
 
 	left = status_replace(
-	    c, NULL, options_get_string(&s->options, "status-left"), t, 1);
+	    c, NULL, options_string(&s->options, OPTC_STATUS_LEFT), t, 1);
 
-	*size = options_get_number(&s->options, "status-left-length");
+	*size = options_number(&s->options, OPTC_STATUS_LEFT_LENGTH);
 	leftlen = screen_write_cstrlen(utf8flag, "%s", left);
 	if (leftlen < *size)
 		*size = leftlen;
@@ -85,20 +85,20 @@ status_redraw_get_right(struct client *c,
 	u_char		 fg, bg, attr;
 	size_t		 rightlen;
 
-	fg = options_get_number(&s->options, "status-right-fg");
+	fg = options_number(&s->options, OPTC_STATUS_RIGHT_FG);
 	if (fg != 8)
 		colour_set_fg(gc, fg);
-	bg = options_get_number(&s->options, "status-right-bg");
+	bg = options_number(&s->options, OPTC_STATUS_RIGHT_BG);
 	if (bg != 8)
 		colour_set_bg(gc, bg);
-	attr = options_get_number(&s->options, "status-right-attr");
+	attr = options_number(&s->options, OPTC_STATUS_RIGHT_ATTR);
 	if (attr != 0)
 		gc->attr = attr;
 
 	right = status_replace(
-	    c, NULL, options_get_string(&s->options, "status-right"), t, 1);
+	    c, NULL, options_string(&s->options, OPTC_STATUS_RIGHT), t, 1);
 
-	*size = options_get_number(&s->options, "status-right-length");
+	*size = options_number(&s->options, OPTC_STATUS_RIGHT_LENGTH);
 	rightlen = screen_write_cstrlen(utf8flag, "%s", right);
 	if (rightlen < *size)
 		*size = rightlen;
@@ -122,7 +122,7 @@ status_redraw(struct client *c)
 	int			larrow, rarrow, utf8flag;
 
 	/* No status line? */
-	if (c->tty.sy == 0 || !options_get_number(&s->options, "status"))
+	if (c->tty.sy == 0 || !options_number(&s->options, OPTC_STATUS))
 		return (1);
 	left = right = NULL;
 	larrow = rarrow = 0;
@@ -134,9 +134,9 @@ status_redraw(struct client *c)
 
 	/* Set up default colour. */
 	memcpy(&stdgc, &grid_default_cell, sizeof gc);
-	colour_set_fg(&stdgc, options_get_number(&s->options, "status-fg"));
-	colour_set_bg(&stdgc, options_get_number(&s->options, "status-bg"));
-	stdgc.attr |= options_get_number(&s->options, "status-attr");
+	colour_set_fg(&stdgc, options_number(&s->options, OPTC_STATUS_FG));
+	colour_set_bg(&stdgc, options_number(&s->options, OPTC_STATUS_BG));
+	stdgc.attr |= options_number(&s->options, OPTC_STATUS_ATTR);
 
 	/* Create the target screen. */
 	memcpy(&old_status, &c->status, sizeof old_status);
@@ -151,7 +151,7 @@ status_redraw(struct client *c)
 		goto out;
 
 	/* Get UTF-8 flag. */
-	utf8flag = options_get_number(&s->options, "status-utf8");
+	utf8flag = options_number(&s->options, OPTC_STATUS_UTF8);
 
 	/* Work out left and right strings. */
 	memcpy(&lgc, &stdgc, sizeof lgc);
@@ -307,7 +307,7 @@ draw:
 	else
 		wloffset = 0;
 	if (wlwidth < wlavailable) {
-		switch (options_get_number(&s->options, "status-justify")) {
+		switch (options_number(&s->options, OPTC_STATUS_JUSTIFY)) {
 		case 1:	/* centered */
 			wloffset += (wlavailable - wlwidth) / 2;
 			break;
@@ -570,11 +570,11 @@ status_width(struct client *c, struct winlink *wl, time_t t)
 	size_t		 size;
 	int		 utf8flag;
 
-	utf8flag = options_get_number(&s->options, "status-utf8");
+	utf8flag = options_number(&s->options, OPTC_STATUS_UTF8);
 
-	fmt = options_get_string(&wl->window->options, "window-status-format");
+	fmt = options_string(&wl->window->options, OPTC_WINDOW_STATUS_FORMAT);
 	if (wl == s->curw)
-		fmt = options_get_string(oo, "window-status-current-format");
+		fmt = options_string(oo, OPTC_WINDOW_STATUS_CURRENT_FORMAT);
 
 	text = status_replace(c, wl, fmt, t, 1);
 	size = screen_write_cstrlen(utf8flag, "%s", text);
@@ -594,27 +594,27 @@ status_print(
 	char   		*text;
 	u_char		 fg, bg, attr;
 
-	fg = options_get_number(oo, "window-status-fg");
+	fg = options_number(oo, OPTC_WINDOW_STATUS_FG);
 	if (fg != 8)
 		colour_set_fg(gc, fg);
-	bg = options_get_number(oo, "window-status-bg");
+	bg = options_number(oo, OPTC_WINDOW_STATUS_BG);
 	if (bg != 8)
 		colour_set_bg(gc, bg);
-	attr = options_get_number(oo, "window-status-attr");
+	attr = options_number(oo, OPTC_WINDOW_STATUS_ATTR);
 	if (attr != 0)
 		gc->attr = attr;
-	fmt = options_get_string(oo, "window-status-format");
+	fmt = options_string(oo, OPTC_WINDOW_STATUS_FORMAT);
 	if (wl == s->curw) {
-		fg = options_get_number(oo, "window-status-current-fg");
+		fg = options_number(oo, OPTC_WINDOW_STATUS_CURRENT_FG);
 		if (fg != 8)
 			colour_set_fg(gc, fg);
-		bg = options_get_number(oo, "window-status-current-bg");
+		bg = options_number(oo, OPTC_WINDOW_STATUS_CURRENT_BG);
 		if (bg != 8)
 			colour_set_bg(gc, bg);
-		attr = options_get_number(oo, "window-status-current-attr");
+		attr = options_number(oo, OPTC_WINDOW_STATUS_CURRENT_ATTR);
 		if (attr != 0)
 			gc->attr = attr;
-		fmt = options_get_string(oo, "window-status-current-format");
+		fmt = options_string(oo, OPTC_WINDOW_STATUS_CURRENT_FORMAT);
 	}
 
 	if (session_alert_has(s, wl, WINDOW_ACTIVITY) ||
@@ -652,7 +652,7 @@ status_message_set(struct client *c, const char *fmt, ...)
 	if (s == NULL)
 		limit = 0;
 	else
-		limit = options_get_number(&s->options, "message-limit");
+		limit = options_number(&s->options, OPTC_MESSAGE_LIMIT);
 	if (ARRAY_LENGTH(&c->message_log) > limit) {
 		limit = ARRAY_LENGTH(&c->message_log) - limit;
 		for (i = 0; i < limit; i++) {
@@ -662,7 +662,7 @@ status_message_set(struct client *c, const char *fmt, ...)
 		}
 	}
 
-	delay = options_get_number(&c->session->options, "display-time");
+	delay = options_number(&c->session->options, OPTC_DISPLAY_TIME);
 	tv.tv_sec = delay / 1000;
 	tv.tv_usec = (delay % 1000) * 1000L;
 
@@ -716,16 +716,16 @@ status_message_redraw(struct client *c)
 	memcpy(&old_status, &c->status, sizeof old_status);
 	screen_init(&c->status, c->tty.sx, 1, 0);
 
-	utf8flag = options_get_number(&s->options, "status-utf8");
+	utf8flag = options_number(&s->options, OPTC_STATUS_UTF8);
 
 	len = screen_write_strlen(utf8flag, "%s", c->message_string);
 	if (len > c->tty.sx)
 		len = c->tty.sx;
 
 	memcpy(&gc, &grid_default_cell, sizeof gc);
-	colour_set_fg(&gc, options_get_number(&s->options, "message-fg"));
-	colour_set_bg(&gc, options_get_number(&s->options, "message-bg"));
-	gc.attr |= options_get_number(&s->options, "message-attr");
+	colour_set_fg(&gc, options_number(&s->options, OPTC_MESSAGE_FG));
+	colour_set_bg(&gc, options_number(&s->options, OPTC_MESSAGE_BG));
+	gc.attr |= options_number(&s->options, OPTC_MESSAGE_ATTR);
 
 	screen_write_start(&ctx, NULL, &c->status);
 
@@ -768,7 +768,7 @@ status_prompt_set(struct client *c, const char *msg,
 
 	c->prompt_flags = flags;
 
-	keys = options_get_number(&c->session->options, "status-keys");
+	keys = options_number(&c->session->options, OPTC_STATUS_KEYS);
 	if (keys == MODEKEY_EMACS)
 		mode_key_init(&c->prompt_mdata, &mode_key_tree_emacs_edit);
 	else
@@ -831,7 +831,7 @@ status_prompt_redraw(struct client *c)
 	memcpy(&old_status, &c->status, sizeof old_status);
 	screen_init(&c->status, c->tty.sx, 1, 0);
 
-	utf8flag = options_get_number(&s->options, "status-utf8");
+	utf8flag = options_number(&s->options, OPTC_STATUS_UTF8);
 
 	len = screen_write_strlen(utf8flag, "%s", c->prompt_string);
 	if (len > c->tty.sx)
@@ -839,9 +839,9 @@ status_prompt_redraw(struct client *c)
 	off = 0;
 
 	memcpy(&gc, &grid_default_cell, sizeof gc);
-	colour_set_fg(&gc, options_get_number(&s->options, "message-fg"));
-	colour_set_bg(&gc, options_get_number(&s->options, "message-bg"));
-	gc.attr |= options_get_number(&s->options, "message-attr");
+	colour_set_fg(&gc, options_number(&s->options, OPTC_MESSAGE_FG));
+	colour_set_bg(&gc, options_number(&s->options, OPTC_MESSAGE_BG));
+	gc.attr |= options_number(&s->options, OPTC_MESSAGE_ATTR);
 
 	screen_write_start(&ctx, NULL, &c->status);
 
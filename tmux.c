@@ -335,6 +335,8 @@ main(int argc, char **argv)
 	oo = &global_options;
 	options_set_number(oo, "quiet", quiet);
 	options_set_number(oo, "escape-time", 500);
+	options_set_number(oo, "history-memory-budget", 0);
+	options_set_number(oo, "render-interval", 0);
 
 	options_init(&global_s_options, NULL);
 	so = &global_s_options;
@@ -404,6 +406,8 @@ main(int argc, char **argv)
 	options_set_number(wo, "clock-mode-style", 1);
 	options_set_number(wo, "force-height", 0);
 	options_set_number(wo, "force-width", 0);
+	options_set_number(wo, "history-compress", 0);
+	options_set_number(wo, "history-spill", 0);
 	options_set_number(wo, "main-pane-height", 24);
 	options_set_number(wo, "main-pane-width", 81);
 	options_set_number(wo, "mode-attr", 0);
@@ -58,9 +58,18 @@ extern char   **environ;
 /* Automatic name refresh interval, in milliseconds. */
 #define NAME_INTERVAL 500
 
-/* Maximum data to buffer for output before suspending reading from panes. */
+/* Maximum data to buffer for a client before it stops being sent updates. */
 #define BACKOFF_THRESHOLD 1024
 
+/*
+ * Maximum pane output to parse at once. Any more is left until the next time
+ * round the server loop, after other panes and clients have had a turn.
+ */
+#define INPUT_BUDGET 16384
+
+/* Initial size of the buffer collecting output to a terminal. */
+#define TTY_OUTSIZE 8192
+
 /*
  * Maximum sizes of strings in message data. Don't forget to bump
  * PROTOCOL_VERSION if any of these change!
@@ -207,6 +216,7 @@ enum tty_code_code {
 	TTYC_ICH1,	/* insert_character, ic */
 	TTYC_IL,	/* parm_insert_line, IL */
 	TTYC_IL1,	/* insert_line, il */
+	TTYC_INDN,	/* parm_index, SF */
 	TTYC_INVIS,	/* enter_secure_mode, mk */
 	TTYC_IS1,	/* init_1string, i1 */
 	TTYC_IS2,	/* init_2string, i2 */
@@ -552,6 +562,10 @@ struct utf8_data {
 	u_int	width;
 };
 
+/* UTF-8 width table, one block for each 256 code points. */
+#define UTF8_WIDTH_INDEX (0x110000 / 256)
+#define UTF8_WIDTH_BLOCK (256 / 4)
+
 /* Grid output. */
 #if defined(DEBUG) && \
     ((defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L) || \
@@ -596,17 +610,83 @@ struct grid_utf8 {
 	u_char	data[UTF8_SIZE];
 } __packed;
 
-/* Grid line. */
+/* UTF-8 data for one cell of a line. */
+struct grid_utf8_entry {
+	u_int	px;
+	struct grid_utf8 gu;
+} __packed;
+
+/*
+ * Cell style: attributes, flags and colours. Styles are kept in a palette (see
+ * grid-style.c) and referred to by their index.
+ */
+struct grid_style {
+	u_char	attr;
+	u_char	flags;
+	u_char	fg;
+	u_char	bg;
+
+	u_int	references;
+	u_short	next;		/* next in hash chain or free list */
+};
+#define GRID_STYLE_DEFAULT 0
+#define GRID_STYLE_NONE 0xffff
+
+/* Style of a cell or palette entry as one integer. */
+#define grid_style_key(gc) ((gc)->attr | (gc)->flags << 8 | \
+    (gc)->fg << 16 | (u_int) (gc)->bg << 24)
+
+/* Run of cells with the same style in a packed line. */
+struct grid_run {
+	u_int	px;
+	u_short	style;
+} __packed;
+
+/*
+ * Grid line. History lines may be packed: rundata holds the runs followed by
+ * the characters (one per cell) and celldata is NULL.
+ */
 struct grid_line {
 	u_int	cellsize;
+	u_int	cellalloc;
 	struct grid_cell *celldata;
 
+	u_int	runsize;
+	struct grid_run *rundata;
+
 	u_int	utf8size;
-	struct grid_utf8 *utf8data;
+	u_int	utf8alloc;
+	struct grid_utf8_entry *utf8data; /* only UTF-8 cells, sorted by px */
+
+	u_int	*references;	/* lines sharing this storage, or NULL */
 
 	int	flags;
 } __packed;
 
+/* Line recently moved into the history, by hash. */
+struct grid_dedup {
+	uint32_t hash;
+	u_int	 id;		/* line number plus hdropped */
+};
+#define GRID_DEDUP_SIZE 256
+
+/* Block of compressed history lines. */
+struct grid_block {
+	u_char	*data;
+	size_t	 size;
+	size_t	 rawsize;	/* size before compression */
+	size_t	 linesize;	/* size of the lines' storage */
+	off_t	 offset;	/* offset in spill file if data is NULL */
+
+	struct grid_line *linedata; /* decompressed lines or NULL */
+	TAILQ_ENTRY(grid_block) entry;
+};
+TAILQ_HEAD(grid_blocks, grid_block);
+#define GRID_BLOCK_LINES 64
+
+/* Characters of a packed line. */
+#define grid_line_text(gl) ((u_char *) ((gl)->rundata + (gl)->runsize))
+
 /* Entire grid of cells. */
 struct grid {
 	int	flags;
@@ -617,13 +697,141 @@ struct grid {
 
 	u_int	hsize;
 	u_int	hlimit;
+	size_t	hbytes;		/* memory used by the history */
+
+	struct grid_line *linedata;	/* ring of lines */
+	u_int	lsize;
+	u_int	loffset;
+
+	/* Storage from freed lines kept for reuse, all poolsx wide. */
+	u_int	poolsx;
+	ARRAY_DECL(, struct grid_cell *) cellpool;
+	u_long	poolsaved;	/* allocations avoided */
+
+	struct grid_cell peekcell; /* last cell read from a packed line */
+
+	/* Recent history lines, for sharing storage with identical lines. */
+	u_int	hdropped;	/* lines dropped from the top of the history */
+	struct grid_dedup *dedup;
+	u_long	dedupsearched;
+	u_long	deduphits;
+
+	/* Oldest hcomp lines of history, compressed and not in the ring. */
+	u_int	hcomp;
+	u_int	bskip;		/* lines dropped from first block */
+	ARRAY_DECL(, struct grid_block *) blocks;
+	struct grid_blocks bcache;
+	u_int	bcached;
+
+	/* Spill file for the oldest bspilled blocks. */
+	u_int	bspilled;
+	int	spillfd;
+	u_char *spillmap;
+	size_t	spillmapsize;
+	off_t	spillsize;
+	size_t	spilllive;
+};
 
-	struct grid_line *linedata;
+/* Option codes, one for each entry in the set-option tables. */
+enum options_code {
+	/* Server options. */
+	OPTC_ESCAPE_TIME,
+	OPTC_HISTORY_MEMORY_BUDGET,
+	OPTC_QUIET,
+	OPTC_RENDER_INTERVAL,
+
+	/* Session options. */
+	OPTC_BASE_INDEX,
+	OPTC_BELL_ACTION,
+	OPTC_BUFFER_LIMIT,
+	OPTC_DEFAULT_COMMAND,
+	OPTC_DEFAULT_PATH,
+	OPTC_DEFAULT_SHELL,
+	OPTC_DEFAULT_TERMINAL,
+	OPTC_DISPLAY_PANES_COLOUR,
+	OPTC_DISPLAY_PANES_ACTIVE_COLOUR,
+	OPTC_DISPLAY_PANES_TIME,
+	OPTC_DISPLAY_TIME,
+	OPTC_HISTORY_LIMIT,
+	OPTC_LOCK_AFTER_TIME,
+	OPTC_LOCK_COMMAND,
+	OPTC_LOCK_SERVER,
+	OPTC_MESSAGE_ATTR,
+	OPTC_MESSAGE_BG,
+	OPTC_MESSAGE_FG,
+	OPTC_MESSAGE_LIMIT,
+	OPTC_MOUSE_SELECT_PANE,
+	OPTC_PANE_ACTIVE_BORDER_BG,
+	OPTC_PANE_ACTIVE_BORDER_FG,
+	OPTC_PANE_BORDER_BG,
+	OPTC_PANE_BORDER_FG,
+	OPTC_PREFIX,
+	OPTC_REPEAT_TIME,
+	OPTC_SET_REMAIN_ON_EXIT,
+	OPTC_SET_TITLES,
+	OPTC_SET_TITLES_STRING,
+	OPTC_STATUS,
+	OPTC_STATUS_ATTR,
+	OPTC_STATUS_BG,
+	OPTC_STATUS_FG,
+	OPTC_STATUS_INTERVAL,
+	OPTC_STATUS_JUSTIFY,
+	OPTC_STATUS_KEYS,
+	OPTC_STATUS_LEFT,
+	OPTC_STATUS_LEFT_ATTR,
+	OPTC_STATUS_LEFT_BG,
+	OPTC_STATUS_LEFT_FG,
+	OPTC_STATUS_LEFT_LENGTH,
+	OPTC_STATUS_RIGHT,
+	OPTC_STATUS_RIGHT_ATTR,
+	OPTC_STATUS_RIGHT_BG,
+	OPTC_STATUS_RIGHT_FG,
+	OPTC_STATUS_RIGHT_LENGTH,
+	OPTC_STATUS_UTF8,
+	OPTC_TERMINAL_OVERRIDES,
+	OPTC_UPDATE_ENVIRONMENT,
+	OPTC_VISUAL_ACTIVITY,
+	OPTC_VISUAL_BELL,
+	OPTC_VISUAL_CONTENT,
+
+	/* Window options. */
+	OPTC_AGGRESSIVE_RESIZE,
+	OPTC_ALTERNATE_SCREEN,
+	OPTC_AUTOMATIC_RENAME,
+	OPTC_CLOCK_MODE_COLOUR,
+	OPTC_CLOCK_MODE_STYLE,
+	OPTC_FORCE_HEIGHT,
+	OPTC_FORCE_WIDTH,
+	OPTC_HISTORY_COMPRESS,
+	OPTC_HISTORY_SPILL,
+	OPTC_MAIN_PANE_HEIGHT,
+	OPTC_MAIN_PANE_WIDTH,
+	OPTC_MODE_ATTR,
+	OPTC_MODE_BG,
+	OPTC_MODE_FG,
+	OPTC_MODE_KEYS,
+	OPTC_MODE_MOUSE,
+	OPTC_MONITOR_ACTIVITY,
+	OPTC_MONITOR_CONTENT,
+	OPTC_REMAIN_ON_EXIT,
+	OPTC_SYNCHRONIZE_PANES,
+	OPTC_UTF8,
+	OPTC_WINDOW_STATUS_ATTR,
+	OPTC_WINDOW_STATUS_BG,
+	OPTC_WINDOW_STATUS_CURRENT_ATTR,
+	OPTC_WINDOW_STATUS_CURRENT_BG,
+	OPTC_WINDOW_STATUS_CURRENT_FG,
+	OPTC_WINDOW_STATUS_CURRENT_FORMAT,
+	OPTC_WINDOW_STATUS_FG,
+	OPTC_WINDOW_STATUS_FORMAT,
+	OPTC_WORD_SEPARATORS,
+	OPTC_XTERM_KEYS,
 };
+#define NOPTCODE (OPTC_XTERM_KEYS + 1)
 
 /* Option data structures. */
 struct options_entry {
-	char		*name;
+	const char	*name;
 
 	enum {
 		OPTIONS_STRING,
@@ -636,12 +844,11 @@ struct options_entry {
 	void		*data;
 
 	void		 (*freefn)(void *);
-
-	SPLAY_ENTRY(options_entry) entry;
 };
 
 struct options {
-	SPLAY_HEAD(options_tree, options_entry) tree;
+	struct options_entry *slots;	/* indexed by option code */
+	bitstr_t	*set;		/* options set in this tree */
 	struct options	*parent;
 };
 
@@ -709,6 +916,8 @@ struct screen {
 struct screen_write_ctx {
 	struct window_pane *wp;
 	struct screen	*s;
+
+	u_int		 scrolled;	/* linefeeds not yet applied */
 };
 
 /* Screen size. */
@@ -731,7 +940,6 @@ struct input_ctx {
 	u_char		*buf;
 	size_t		 len;
 	size_t		 off;
-	size_t		 was;
 
 	struct grid_cell cell;
 
@@ -787,6 +995,7 @@ struct window_pane {
 	int		 flags;
 #define PANE_REDRAW 0x1
 #define PANE_FREEZE 0x2
+#define PANE_PENDING 0x4
 
 	char		*cmd;
 	char		*shell;
@@ -816,10 +1025,28 @@ struct window_pane {
 	const struct window_mode *mode;
 	void		*modedata;
 
+	time_t		 view_time;	/* last seen by an attached client */
+
 	TAILQ_ENTRY(window_pane) entry;
+	TAILQ_ENTRY(window_pane) pending_entry;
 };
 TAILQ_HEAD(window_panes, window_pane);
 
+/*
+ * Window options used on hot paths, copied out of the options tree and
+ * refreshed when options_generation changes.
+ */
+struct window_cache {
+	u_int		 generation;
+
+	int		 utf8;
+	int		 alternate_screen;
+	int		 synchronize_panes;
+	int		 mode_keys;
+	int		 mode_mouse;
+	struct grid_cell mode_gc;
+};
+
 /* Window structure. */
 struct window {
 	char		*name;
@@ -842,6 +1069,7 @@ struct window {
 #define WINDOW_REDRAW 0x10
 
 	struct options	 options;
+	struct window_cache cache;
 
 	u_int		 references;
 };
@@ -921,6 +1149,21 @@ struct session_group {
 };
 TAILQ_HEAD(session_groups, session_group);
 
+/* Session options used when drawing and updating clients, as above. */
+struct session_cache {
+	u_int		 generation;
+
+	int		 status;
+	int		 status_interval;
+	int		 set_titles;
+	int		 mouse_select_pane;
+	int		 repeat_time;
+	struct grid_cell border_gc;
+	struct grid_cell active_border_gc;
+	int		 display_panes_colour;
+	int		 display_panes_active_colour;
+};
+
 struct session {
 	char		*name;
 
@@ -935,6 +1178,7 @@ struct session {
 	struct winlinks	 windows;
 
 	struct options	 options;
+	struct session_cache cache;
 
 	struct paste_stack buffers;
 
@@ -954,6 +1198,21 @@ struct session {
 };
 ARRAY_DECL(sessions, struct session *);
 
+/* Cell in the copy of what is on a terminal. */
+struct tty_frame_cell {
+	struct grid_cell cell;
+	struct grid_utf8 utf8;
+} __packed;
+#define TTY_FRAME_UNKNOWN 0x80
+
+/* Copy of what is on a terminal, shared by terminals showing the same. */
+struct tty_frame {
+	u_int		 references;
+
+	struct tty_frame_cell **rows;
+	struct tty_frame_cell *data;
+};
+
 /* TTY information. */
 struct tty_key {
 	char		 ch;
@@ -1000,6 +1259,12 @@ struct tty {
 	int		 fd;
 	struct bufferevent *event;
 
+	u_char		*obuf;
+	size_t		 olen;
+	size_t		 osize;
+
+	struct tty_frame *frame;
+
 	int		 log_fd;
 
 	struct termios	 tio;
@@ -1079,6 +1344,8 @@ struct client {
 
 	struct tty	 tty;
 	struct event	 repeat_timer;
+	struct event	 render_timer;
+	u_int		 dropped;	/* frames skipped while backed off */
 
 	struct timeval	 status_timer;
 	struct jobs	 status_jobs;
@@ -1096,6 +1363,9 @@ struct client {
 #define CLIENT_DEAD 0x200
 #define CLIENT_BORDERS 0x400
 #define CLIENT_READONLY 0x800
+#define CLIENT_RENDERWAIT 0x1000 /* wait for render-interval before drawing */
+#define CLIENT_DAMAGED 0x2000	/* pane updates held back while waiting */
+#define CLIENT_BACKOFF 0x4000	/* too much output queued, skip updates */
 	int		 flags;
 
 	struct event	 identify_timer;
@@ -1229,6 +1499,7 @@ SPLAY_HEAD(key_bindings, key_binding);
 /* Set/display option data. */
 struct set_option_entry {
 	const char	*name;
+	enum options_code code;
 	enum {
 		SET_OPTION_STRING,
 		SET_OPTION_NUMBER,
@@ -1288,21 +1559,26 @@ void	mode_key_init(struct mode_key_data *, struct mode_key_tree *);
 enum mode_key_cmd mode_key_lookup(struct mode_key_data *, int);
 
 /* options.c */
-int	options_cmp(struct options_entry *, struct options_entry *);
-SPLAY_PROTOTYPE(options_tree, options_entry, entry, options_cmp);
+extern u_int options_generation;
+enum options_code options_find_code(const char *);
 void	options_init(struct options *, struct options *);
 void	options_free(struct options *);
+struct options_entry *options_lookup1(struct options *, enum options_code);
+struct options_entry *options_lookup(struct options *, enum options_code);
 struct options_entry *options_find1(struct options *, const char *);
 struct options_entry *options_find(struct options *, const char *);
 void	options_remove(struct options *, const char *);
 struct options_entry *printflike3 options_set_string(
 	    struct options *, const char *, const char *, ...);
+char   *options_string(struct options *, enum options_code);
 char   *options_get_string(struct options *, const char *);
 struct options_entry *options_set_number(
 	    struct options *, const char *, long long);
+long long options_number(struct options *, enum options_code);
 long long options_get_number(struct options *, const char *);
 struct options_entry *options_set_data(
 	    struct options *, const char *, void *, void (*)(void *));
+void   *options_data(struct options *, enum options_code);
 void   *options_get_data(struct options *, const char *);
 
 /* job.c */
@@ -1346,6 +1622,7 @@ void	tty_putcode1(struct tty *, enum tty_code_code, int);
 void	tty_putcode2(struct tty *, enum tty_code_code, int, int);
 void	tty_puts(struct tty *, const char *);
 void	tty_putc(struct tty *, u_char);
+void	tty_flush(struct tty *);
 void	tty_pututf8(struct tty *, const struct grid_utf8 *);
 void	tty_init(struct tty *, int, char *);
 void	tty_resize(struct tty *);
@@ -1361,6 +1638,7 @@ void	tty_write(void (*)(
 	    struct tty *, const struct tty_ctx *), const struct tty_ctx *);
 void	tty_cmd_alignmenttest(struct tty *, const struct tty_ctx *);
 void	tty_cmd_cell(struct tty *, const struct tty_ctx *);
+void	tty_cmd_cells(struct tty *, const struct tty_ctx *);
 void	tty_cmd_clearendofline(struct tty *, const struct tty_ctx *);
 void	tty_cmd_clearendofscreen(struct tty *, const struct tty_ctx *);
 void	tty_cmd_clearline(struct tty *, const struct tty_ctx *);
@@ -1372,9 +1650,28 @@ void	tty_cmd_deleteline(struct tty *, const struct tty_ctx *);
 void	tty_cmd_insertcharacter(struct tty *, const struct tty_ctx *);
 void	tty_cmd_insertline(struct tty *, const struct tty_ctx *);
 void	tty_cmd_linefeed(struct tty *, const struct tty_ctx *);
+void	tty_cmd_scrollup(struct tty *, const struct tty_ctx *);
 void	tty_cmd_utf8character(struct tty *, const struct tty_ctx *);
 void	tty_cmd_reverseindex(struct tty *, const struct tty_ctx *);
 
+/* tty-frame.c */
+void	tty_frame_resize(struct tty *);
+void	tty_frame_free(struct tty *);
+void	tty_frame_invalidate(struct tty *);
+int	tty_frame_join(struct tty *, struct tty *);
+void	tty_frame_lead(struct tty *, u_int);
+void	tty_frame_follow(struct tty *, struct tty *);
+void	tty_frame_unknown(struct tty *, u_int, u_int, u_int);
+void	tty_frame_clear(struct tty *, u_int, u_int, u_int);
+int	tty_frame_cleared(struct tty *, u_int, u_int, u_int);
+void	tty_frame_linefeed(struct tty *);
+void	tty_frame_code(struct tty *, enum tty_code_code, u_int);
+void	tty_frame_putc(struct tty *, u_char);
+void	tty_frame_putn(struct tty *, const u_char *, u_int);
+void	tty_frame_pututf8(struct tty *, const struct grid_utf8 *);
+int	tty_frame_same(struct tty *, u_int, u_int,
+	    const struct grid_cell *, const struct grid_utf8 *);
+
 /* tty-term.c */
 extern struct tty_terms tty_terms;
 extern struct tty_term_code_entry tty_term_codes[NTTYCODE];
@@ -1647,7 +1944,7 @@ void	 recalculate_sizes(void);
 /* input.c */
 void	 input_init(struct window_pane *);
 void	 input_free(struct window_pane *);
-void	 input_parse(struct window_pane *);
+void	 input_parse(struct window_pane *, size_t);
 
 /* input-key.c */
 void	 input_key(struct window_pane *, int);
@@ -1674,17 +1971,44 @@ extern const struct grid_cell grid_default_cell;
 struct grid *grid_create(u_int, u_int, u_int);
 void	 grid_destroy(struct grid *);
 int	 grid_compare(struct grid *, struct grid *);
+const struct grid_line *grid_peek_line(struct grid *, u_int);
+struct grid_line *grid_get_line(struct grid *, u_int);
+struct grid_line *grid_ring_line(struct grid *, u_int);
+void	 grid_reserve_lines(struct grid *, u_int);
+void	 grid_free_line(struct grid *, struct grid_line *);
+void	 grid_unshare_line(struct grid *, struct grid_line *);
+size_t	 grid_history_size(struct grid *);
+void	 grid_drop_history(struct grid *, u_int);
+size_t	 grid_line_size(const struct grid_line *);
+int	 grid_pack_line(struct grid_line *);
+void	 grid_free_runs(struct grid_line *);
+size_t	 grid_history_line_size(const struct grid_line *);
+void	 grid_packed_cell(const struct grid_line *, u_int, struct grid_cell *);
+const struct grid_utf8 *grid_line_utf8(const struct grid_line *, u_int);
+struct grid_utf8 *grid_line_add_utf8(struct grid_line *, u_int);
 void	 grid_collect_history(struct grid *);
-void	 grid_scroll_history(struct grid *);
-void	 grid_scroll_history_region(struct grid *, u_int, u_int);
+void	 grid_clear_history(struct grid *);
+void	 grid_grow_history(struct grid *, u_int);
+void	 grid_shrink_history(struct grid *, u_int);
+void	 grid_scroll_history(struct grid *, u_int);
+void	 grid_scroll_history_region(struct grid *, u_int, u_int, u_int);
 void	 grid_expand_line(struct grid *, u_int, u_int);
-void	 grid_expand_line_utf8(struct grid *, u_int, u_int);
 const struct grid_cell *grid_peek_cell(struct grid *, u_int, u_int);
+const struct grid_cell *grid_peek_cell_unchecked(struct grid *, u_int, u_int);
 struct grid_cell *grid_get_cell(struct grid *, u_int, u_int);
 void	 grid_set_cell(struct grid *, u_int, u_int, const struct grid_cell *);
+void	 grid_set_cell_unchecked(
+	     struct grid *, u_int, u_int, const struct grid_cell *);
+void	 grid_set_cells(struct grid *, u_int, u_int,
+	     const struct grid_cell *, const u_char *, u_int);
+void	 grid_set_cells_unchecked(struct grid *, u_int, u_int,
+	     const struct grid_cell *, const u_char *, u_int);
 const struct grid_utf8 *grid_peek_utf8(struct grid *, u_int, u_int);
+const struct grid_utf8 *grid_peek_utf8_unchecked(struct grid *, u_int, u_int);
 struct grid_utf8 *grid_get_utf8(struct grid *, u_int, u_int);
 void	 grid_set_utf8(struct grid *, u_int, u_int, const struct grid_utf8 *);
+void	 grid_set_utf8_unchecked(
+	     struct grid *, u_int, u_int, const struct grid_utf8 *);
 void	 grid_clear(struct grid *, u_int, u_int, u_int, u_int);
 void	 grid_clear_lines(struct grid *, u_int, u_int);
 void	 grid_move_lines(struct grid *, u_int, u_int, u_int);
@@ -1693,6 +2017,22 @@ char	*grid_string_cells(struct grid *, u_int, u_int, u_int);
 void	 grid_duplicate_lines(
 	     struct grid *, u_int, struct grid *, u_int, u_int);
 
+/* grid-block.c */
+void	 grid_compress_history(struct grid *, u_int);
+const struct grid_line *grid_block_peek_line(struct grid *, u_int);
+void	 grid_block_drop_line(struct grid *);
+void	 grid_block_free_all(struct grid *);
+void	 grid_block_thaw(struct grid *, u_int);
+void	 grid_block_sizes(struct grid *, size_t *, size_t *, size_t *);
+void	 grid_spill_history(struct grid *, u_int);
+
+/* grid-style.c */
+extern u_int grid_styles_count;
+u_short	 grid_style_add(const struct grid_cell *);
+void	 grid_style_ref(u_short);
+void	 grid_style_free(u_short);
+void	 grid_style_set(u_short, struct grid_cell *);
+
 /* grid-utf8.c */
 size_t	 grid_utf8_size(const struct grid_utf8 *);
 size_t	 grid_utf8_copy(const struct grid_utf8 *, char *, size_t);
@@ -1705,12 +2045,14 @@ const struct grid_cell *grid_view_peek_cell(struct grid *, u_int, u_int);
 struct grid_cell *grid_view_get_cell(struct grid *, u_int, u_int);
 void	 grid_view_set_cell(
 	     struct grid *, u_int, u_int, const struct grid_cell *);
+void	 grid_view_set_cells(struct grid *, u_int, u_int,
+	     const struct grid_cell *, const u_char *, u_int);
 const struct grid_utf8 *grid_view_peek_utf8(struct grid *, u_int, u_int);
 struct grid_utf8 *grid_view_get_utf8(struct grid *, u_int, u_int);
 void	 grid_view_set_utf8(
 	     struct grid *, u_int, u_int, const struct grid_utf8 *);
 void	 grid_view_clear(struct grid *, u_int, u_int, u_int, u_int);
-void	 grid_view_scroll_region_up(struct grid *, u_int, u_int);
+void	 grid_view_scroll_region_up(struct grid *, u_int, u_int, u_int);
 void	 grid_view_scroll_region_down(struct grid *, u_int, u_int);
 void	 grid_view_insert_lines(struct grid *, u_int, u_int);
 void	 grid_view_insert_lines_region(struct grid *, u_int, u_int, u_int);
@@ -1724,6 +2066,7 @@ char	*grid_view_string_cells(struct grid *, u_int, u_int, u_int);
 void	 screen_write_start(
 	     struct screen_write_ctx *, struct window_pane *, struct screen *);
 void	 screen_write_stop(struct screen_write_ctx *);
+void	 screen_write_flush(struct screen_write_ctx *);
 size_t printflike2 screen_write_cstrlen(int, const char *, ...);
 void printflike5 screen_write_cnputs(struct screen_write_ctx *,
 	     ssize_t, struct grid_cell *, int, const char *, ...);
@@ -1769,6 +2112,8 @@ void	 screen_write_clearstartofscreen(struct screen_write_ctx *);
 void	 screen_write_clearscreen(struct screen_write_ctx *);
 void	 screen_write_cell(struct screen_write_ctx *,
 	     const struct grid_cell *, const struct utf8_data *);
+void	 screen_write_cells(struct screen_write_ctx *,
+	     const struct grid_cell *, const u_char *, u_int);
 
 /* screen-redraw.c */
 void	 screen_redraw_screen(struct client *, int, int);
@@ -1788,6 +2133,7 @@ int	 screen_check_selection(struct screen *, u_int, u_int);
 
 /* window.c */
 extern struct windows windows;
+extern struct window_panes pending_panes;
 int		 window_cmp(struct window *, struct window *);
 int		 winlink_cmp(struct winlink *, struct winlink *);
 RB_PROTOTYPE(windows, window, entry, window_cmp);
@@ -1808,6 +2154,7 @@ struct window	*window_create(const char *, const char *, const char *,
 		     const char *, struct environ *, struct termios *,
 		     u_int, u_int, u_int, char **);
 void		 window_destroy(struct window *);
+const struct window_cache *window_cache(struct window *);
 void		 window_set_active_at(struct window *, u_int, u_int);
 void		 window_set_active_pane(struct window *, struct window_pane *);
 struct window_pane *window_add_pane(struct window *, u_int);
@@ -1827,6 +2174,8 @@ int		 window_pane_set_mode(
 		     struct window_pane *, const struct window_mode *);
 void		 window_pane_reset_mode(struct window_pane *);
 void		 window_pane_parse(struct window_pane *);
+void		 window_pane_parse_pending(void);
+void		 window_pane_drain(struct window_pane *);
 void		 window_pane_key(struct window_pane *, struct client *, int);
 void		 window_pane_mouse(struct window_pane *,
 		     struct client *, struct mouse_event *);
@@ -1907,6 +2256,7 @@ struct session	*session_create(const char *, const char *, const char *,
 		     struct environ *, struct termios *, int, u_int, u_int,
 		     char **);
 void		 session_destroy(struct session *);
+const struct session_cache *session_cache(struct session *);
 int		 session_index(struct session *, u_int *);
 struct winlink	*session_new(struct session *,
 		     const char *, const char *, const char *, int, char **);
@@ -1926,10 +2276,15 @@ void		 session_group_synchronize_to(struct session *);
 void		 session_group_synchronize_from(struct session *);
 void		 session_group_synchronize1(struct session *, struct session *);
 
+/* utf8-width.c */
+extern const u_char utf8_width_index[UTF8_WIDTH_INDEX];
+extern const u_char utf8_width_blocks[][UTF8_WIDTH_BLOCK];
+
 /* utf8.c */
-void	utf8_build(void);
 int	utf8_open(struct utf8_data *, u_char);
 int	utf8_append(struct utf8_data *, u_char);
+u_int	utf8_decode(
+	    const u_char *, size_t, struct utf8_data *, u_int, size_t *);
 
 /* osdep-*.c */
 char   *osdep_get_name(int, char *);
@@ -1943,10 +2298,17 @@ void printflike1 log_warnx(const char *, ...);
 void printflike1 log_info(const char *, ...);
 void printflike1 log_debug(const char *, ...);
 void printflike1 log_debug2(const char *, ...);
+/* Level 2 debug messages are only built with DEBUG. */
+#if !defined(DEBUG) && \
+    ((defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L) || \
+     (defined(__GNUC__) && __GNUC__ >= 3))
+#define log_debug2(...)
+#endif
 __dead void printflike1 log_fatal(const char *, ...);
 __dead void printflike1 log_fatalx(const char *, ...);
 
 /* xmalloc.c */
+extern uint64_t	 xmalloc_count;
 char		*xstrdup(const char *);
 void		*xcalloc(size_t, size_t);
 void		*xmalloc(size_t);
@@ -0,0 +1,461 @@
+/* $Id$ */
+
+/*
+ * Copyright (c) 2010 Nicholas Marriott <nicm@users.sourceforge.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF MIND, USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING
+ * OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <paths.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tmux.h"
+
+/*
+ * Input parser benchmark. Each stream is fed through input_parse into a pane
+ * with no process or clients, a chunk at a time as if read from a pty, and the
+ * throughput, allocations and a checksum of the final screen are reported. The
+ * streams are files or built-in generators (-g ls, cc or curses; all of them if
+ * there are no files), which always produce the same output so results can be
+ * compared between builds:
+ *
+ *	make bench-input && tools/bench-input -gls tools/UTF-8-demo.txt
+ */
+
+/* Replacements for what is in tmux.c. */
+char		*cfg_file;
+struct options	 global_options;
+struct options	 global_s_options;
+struct options	 global_w_options;
+struct environ	 global_environ;
+
+int		 debug_level;
+time_t		 start_time;
+char		*socket_path;
+int		 login_shell;
+
+#ifndef HAVE_PROGNAME
+char      *__progname = (char *) "bench-input";
+#endif
+
+struct bench_stream {
+	const char	*name;
+	void		 (*generate)(struct evbuffer *);
+};
+
+__dead void	 usage(void);
+void printflike2 bench_printf(struct evbuffer *, const char *, ...);
+u_int		 bench_random(void);
+void		 bench_generate_ls(struct evbuffer *);
+void		 bench_generate_cc(struct evbuffer *);
+void		 bench_generate_curses(struct evbuffer *);
+u_int		 bench_cells(const u_char *, size_t);
+uint32_t	 bench_checksum(struct grid *);
+void		 bench_run(const char *, struct evbuffer *);
+
+const struct bench_stream bench_streams[] = {
+	{ "ls", bench_generate_ls },
+	{ "cc", bench_generate_cc },
+	{ "curses", bench_generate_curses },
+};
+
+/* Size of each generated stream. */
+#define BENCH_SIZE (1024 * 1024)
+
+u_int	bench_seed;
+u_int	bench_generators;
+u_int	bench_sx = 80;
+u_int	bench_sy = 24;
+u_int	bench_hlimit = 2000;
+u_int	bench_repeat = 10;
+size_t	bench_chunk = 4096;
+
+__dead void
+usage(void)
+{
+	fprintf(stderr, "usage: %s [-b chunk] [-g generator] [-l history] "
+	    "[-n repeat] [-x width] [-y height] [file ...]\n", __progname);
+	exit(1);
+}
+
+void
+logfile(unused const char *name)
+{
+}
+
+const char *
+getshell(void)
+{
+	return (_PATH_BSHELL);
+}
+
+int
+checkshell(unused const char *shell)
+{
+	return (1);
+}
+
+int
+areshell(unused const char *shell)
+{
+	return (0);
+}
+
+void
+bench_printf(struct evbuffer *evb, const char *fmt, ...)
+{
+	va_list	ap;
+
+	va_start(ap, fmt);
+	evbuffer_add_vprintf(evb, fmt, ap);
+	va_end(ap);
+}
+
+/* Simple generator so the streams are the same everywhere. */
+u_int
+bench_random(void)
+{
+	bench_seed = bench_seed * 1103515245 + 12345;
+	return ((bench_seed >> 16) & 0x7fff);
+}
+
+/* Coloured ls -l output. */
+void
+bench_generate_ls(struct evbuffer *evb)
+{
+	const char	*colours[] = { "0", "01;34", "01;32", "01;36", "0" };
+	u_int		 n = 0, c;
+
+	while (EVBUFFER_LENGTH(evb) < BENCH_SIZE) {
+		c = bench_random() % nitems(colours);
+		bench_printf(evb, "%crw-r--r--  1 user  staff  %8u Dec %2u "
+		    "%02u:%02u \033[%sm%s%05u.%s\033[0m\r\n",
+		    c == 1 ? 'd' : '-', bench_random() * 7, 1 + n % 31,
+		    bench_random() % 24, bench_random() % 60, colours[c],
+		    c == 1 ? "dir" : "file", n, c == 2 ? "sh" : "c");
+		if (++n % 50 == 0)
+			bench_printf(evb, "total %u\r\n", bench_random());
+	}
+}
+
+/* Compiler log with highlighted diagnostics and long wrapped lines. */
+void
+bench_generate_cc(struct evbuffer *evb)
+{
+	u_int	n = 0, i, len;
+
+	while (EVBUFFER_LENGTH(evb) < BENCH_SIZE) {
+		switch (bench_random() % 4) {
+		case 0:
+			bench_printf(evb, "\033[1mfile%u.c:%u:%u: \033[1;35m"
+			    "warning: \033[0m\033[1munused variable "
+			    "\342\200\230x%u\342\200\231\033[0m\r\n",
+			    n, bench_random() % 2000, bench_random() % 80, n);
+			bench_printf(evb, "  %u |  int x%u;\r\n      |      "
+			    "\033[1;32m^~\033[0m\r\n", bench_random() % 2000, n);
+			break;
+		case 1:
+			bench_printf(evb, "cc -O2 -Wall -c -o file%u.o", n);
+			len = bench_random() % 20;
+			for (i = 0; i < len; i++)
+				bench_printf(evb, " -Iinclude/dir%u", i);
+			bench_printf(evb, " file%u.c\r\n", n);
+			break;
+		default:
+			bench_printf(evb, "  CC      file%u.o\r\n", n);
+			break;
+		}
+		n++;
+	}
+}
+
+/*
+ * Full screen application redrawing parts of the screen. It stays on the
+ * alternate screen so that is what is checked at the end.
+ */
+void
+bench_generate_curses(struct evbuffer *evb)
+{
+	u_int	y, x, i, len;
+
+	bench_printf(evb, "\033[?1049h\033[H\033[2J");
+	while (EVBUFFER_LENGTH(evb) < BENCH_SIZE) {
+		switch (bench_random() % 4) {
+		case 0:
+			/* Status line. */
+			bench_printf(evb, "\033[%u;1H\033[7m %u:%u  -- INSERT "
+			    "--\033[K\033[m", bench_sy, bench_random(),
+			    bench_random() % 80);
+			break;
+		case 1:
+			/* Scroll part of the screen. */
+			bench_printf(evb, "\033[2;%ur\033[%u;1H\n\n\n\033[r",
+			    bench_sy - 1, bench_sy - 1);
+			break;
+		default:
+			/* Redraw some lines with syntax colouring. */
+			y = 1 + bench_random() % (bench_sy - 1);
+			len = 1 + bench_random() % 8;
+			for (i = 0; i < len && y + i < bench_sy; i++) {
+				bench_printf(evb, "\033[%u;1H\033[K", y + i);
+				for (x = 0; x < bench_sx - 20; x += 10) {
+					bench_printf(evb, "\033[3%um%-9.9s ",
+					    bench_random() % 8, x % 20 == 0 ?
+					    "if (x)" : "return");
+				}
+				bench_printf(evb, "\033[m");
+			}
+			break;
+		}
+	}
+}
+
+/*
+ * Count the characters written to the screen, roughly: printable bytes and
+ * UTF-8 lead bytes outside escape sequences.
+ */
+u_int
+bench_cells(const u_char *buf, size_t len)
+{
+	enum { GROUND, ESCAPE, CSI, STRING } state = GROUND;
+	u_int	cells = 0;
+	size_t	i;
+	u_char	ch;
+
+	for (i = 0; i < len; i++) {
+		ch = buf[i];
+		switch (state) {
+		case GROUND:
+			if (ch == '\033')
+				state = ESCAPE;
+			else if ((ch >= 0x20 && ch < 0x7f) || ch >= 0xc0)
+				cells++;
+			break;
+		case ESCAPE:
+			if (ch == '[')
+				state = CSI;
+			else if (ch == ']' || ch == 'k' || ch == 'P')
+				state = STRING;
+			else if (ch >= 0x30)
+				state = GROUND;
+			break;
+		case CSI:
+			if (ch >= 0x40 && ch <= 0x7e)
+				state = GROUND;
+			break;
+		case STRING:
+			if (ch == '\007' || ch == '\\')
+				state = GROUND;
+			break;
+		}
+	}
+	return (cells);
+}
+
+/* FNV-1a hash of the visible screen text. */
+uint32_t
+bench_checksum(struct grid *gd)
+{
+	uint32_t	 hash = 2166136261U;
+	char		*line, *ptr;
+	u_int		 yy;
+
+	for (yy = 0; yy < gd->sy; yy++) {
+		line = grid_string_cells(gd, 0, gd->hsize + yy, gd->sx);
+		for (ptr = line; *ptr != '\0'; ptr++)
+			hash = (hash ^ (u_char) *ptr) * 16777619U;
+		hash = (hash ^ '\n') * 16777619U;
+		xfree(line);
+	}
+	return (hash);
+}
+
+/* Feed a stream through a new pane and print the results. */
+void
+bench_run(const char *name, struct evbuffer *evb)
+{
+	struct window		*w;
+	struct window_pane	*wp;
+	struct timeval		 start, end, tv;
+	const u_char		*buf = EVBUFFER_DATA(evb);
+	size_t			 len = EVBUFFER_LENGTH(evb), off, size;
+	uint64_t		 allocations;
+	double			 secs, total;
+	u_int			 i, cells;
+
+	cells = bench_cells(buf, len);
+
+	w = xcalloc(1, sizeof *w);
+	options_init(&w->options, &global_w_options);
+	TAILQ_INIT(&w->panes);
+	w->sx = bench_sx;
+	w->sy = bench_sy;
+
+	wp = window_pane_create(w, bench_sx, bench_sy, bench_hlimit);
+	if ((wp->event = bufferevent_new(-1, NULL, NULL, NULL, NULL)) == NULL)
+		fatalx("bufferevent_new failed");
+#if defined(LIBEVENT_VERSION_NUMBER) && LIBEVENT_VERSION_NUMBER >= 0x02000000
+	/* Only the bufferevent itself may add to its input otherwise. */
+	evbuffer_unfreeze(wp->event->input, 0);
+#endif
+
+	allocations = xmalloc_count;
+	if (gettimeofday(&start, NULL) != 0)
+		fatal("gettimeofday failed");
+	for (i = 0; i < bench_repeat; i++) {
+		for (off = 0; off < len; off += size) {
+			size = len - off;
+			if (size > bench_chunk)
+				size = bench_chunk;
+			evbuffer_add(wp->event->input, buf + off, size);
+			while (EVBUFFER_LENGTH(wp->event->input) != 0)
+				input_parse(wp, INPUT_BUDGET);
+		}
+	}
+	if (gettimeofday(&end, NULL) != 0)
+		fatal("gettimeofday failed");
+	allocations = xmalloc_count - allocations;
+
+	timersub(&end, &start, &tv);
+	secs = tv.tv_sec + tv.tv_usec / 1000000.0;
+	if (secs == 0)
+		secs = 0.000001;
+	total = (double) len * bench_repeat;
+
+	printf("%s: %zu bytes x %u, %.3f s, %.1f MB/s, %.1f Mcells/s, "
+	    "%llu allocations, history %u, screen %08x\n", name, len,
+	    bench_repeat, secs, total / secs / 1000000,
+	    (double) cells * bench_repeat / secs / 1000000,
+	    (unsigned long long) allocations, wp->base.grid->hsize,
+	    bench_checksum(wp->base.grid));
+
+	bufferevent_free(wp->event);
+	window_pane_destroy(wp);
+	options_free(&w->options);
+	xfree(w);
+}
+
+int
+main(int argc, char **argv)
+{
+	const struct bench_stream	*bs;
+	struct evbuffer			*evb;
+	struct rusage			 ru;
+	const char			*errstr;
+	int				 opt, fd;
+	ssize_t				 n;
+	u_int				 i;
+
+	while ((opt = getopt(argc, argv, "b:g:l:n:x:y:")) != -1) {
+		switch (opt) {
+		case 'b':
+			bench_chunk = strtonum(optarg, 1, INT_MAX, &errstr);
+			if (errstr != NULL)
+				errx(1, "chunk %s", errstr);
+			break;
+		case 'g':
+			for (i = 0; i < nitems(bench_streams); i++) {
+				if (strcmp(optarg, bench_streams[i].name) == 0)
+					break;
+			}
+			if (i == nitems(bench_streams))
+				errx(1, "unknown generator: %s", optarg);
+			bench_generators |= 1 << i;
+			break;
+		case 'l':
+			bench_hlimit = strtonum(optarg, 0, INT_MAX, &errstr);
+			if (errstr != NULL)
+				errx(1, "history %s", errstr);
+			break;
+		case 'n':
+			bench_repeat = strtonum(optarg, 1, INT_MAX, &errstr);
+			if (errstr != NULL)
+				errx(1, "repeat %s", errstr);
+			break;
+		case 'x':
+			bench_sx = strtonum(optarg, 20, SHRT_MAX, &errstr);
+			if (errstr != NULL)
+				errx(1, "width %s", errstr);
+			break;
+		case 'y':
+			bench_sy = strtonum(optarg, 2, SHRT_MAX, &errstr);
+			if (errstr != NULL)
+				errx(1, "height %s", errstr);
+			break;
+		default:
+			usage();
+		}
+	}
+
+	event_init();
+	environ_init(&global_environ);
+	options_init(&global_options, NULL);
+	options_init(&global_s_options, NULL);
+
+	/* The window options the parser uses, as in tmux.c. */
+	options_init(&global_w_options, NULL);
+	options_set_number(&global_w_options, "alternate-screen", 1);
+	options_set_number(&global_w_options, "mode-attr", 0);
+	options_set_number(&global_w_options, "mode-bg", 3);
+	options_set_number(&global_w_options, "mode-fg", 0);
+	options_set_number(&global_w_options, "mode-keys", MODEKEY_EMACS);
+	options_set_number(&global_w_options, "mode-mouse", 0);
+	options_set_number(&global_w_options, "synchronize-panes", 0);
+	options_set_number(&global_w_options, "utf8", 1);
+
+	for (i = optind; i < (u_int) argc; i++) {
+		if ((fd = open(argv[i], O_RDONLY)) == -1)
+			err(1, "%s", argv[i]);
+		evb = evbuffer_new();
+		while ((n = evbuffer_read(evb, fd, 65536)) > 0)
+			;
+		if (n == -1)
+			err(1, "%s", argv[i]);
+		close(fd);
+
+		bench_run(argv[i], evb);
+		evbuffer_free(evb);
+	}
+
+	/* Run the generators asked for, or all of them if nothing else. */
+	if (bench_generators == 0 && optind == argc)
+		bench_generators = (1 << nitems(bench_streams)) - 1;
+	for (i = 0; i < nitems(bench_streams); i++) {
+		if (!(bench_generators & (1 << i)))
+			continue;
+		bs = &bench_streams[i];
+
+		bench_seed = 1;
+		evb = evbuffer_new();
+		bs->generate(evb);
+		bench_run(bs->name, evb);
+		evbuffer_free(evb);
+	}
+
+	if (getrusage(RUSAGE_SELF, &ru) != 0)
+		fatal("getrusage failed");
+	printf("peak RSS %ld KB\n", (long) ru.ru_maxrss);
+	return (0);
+}
@@ -0,0 +1,93 @@
+#!/usr/bin/perl
+#
+# Generate utf8-width.c, the table of character widths used by utf8_width,
+# from the Unicode data included with perl:
+#
+#	perl tools/utf8-width.pl >utf8-width.c
+#
+# Nonspacing and enclosing marks, format characters and the medial and final
+# Hangul jamo are zero width; East Asian wide and fullwidth characters
+# (including unassigned code points in the CJK blocks) are two; everything
+# else is one. The table is in two stages: an index for each block of 256
+# code points and the distinct blocks, with two bits for each code point.
+
+use strict;
+use warnings;
+
+use Unicode::UCD qw(prop_invlist);
+
+my $max = 0x110000;
+my $block = 256;
+my @width = (1) x $max;
+
+sub set_width {
+	my ($prop, $value) = @_;
+	my @list = prop_invlist($prop);
+
+	die "unknown property $prop" unless @list;
+	push @list, $max if @list % 2;
+	while (my ($first, $last) = splice(@list, 0, 2)) {
+		@width[$first .. $last - 1] = ($value) x ($last - $first);
+	}
+}
+
+set_width('East_Asian_Width=Wide', 2);
+set_width('East_Asian_Width=Fullwidth', 2);
+set_width('General_Category=Nonspacing_Mark', 0);
+set_width('General_Category=Enclosing_Mark', 0);
+set_width('General_Category=Format', 0);
+@width[0x1160 .. 0x11ff] = (0) x (0x11ff - 0x1160 + 1);
+$width[0x00ad] = 1;
+
+my (@index, @blocks, %seen);
+for (my $i = 0; $i < $max; $i += $block) {
+	my @bytes;
+	for (my $j = 0; $j < $block; $j += 4) {
+		my $byte = 0;
+		$byte |= $width[$i + $j + $_] << ($_ * 2) for 0 .. 3;
+		push @bytes, $byte;
+	}
+	my $key = join(',', @bytes);
+	if (!exists $seen{$key}) {
+		$seen{$key} = scalar @blocks;
+		push @blocks, [ @bytes ];
+	}
+	push @index, $seen{$key};
+}
+die "too many blocks" if @blocks > 256;
+
+my $version = Unicode::UCD::UnicodeVersion();
+print <<"END";
+/* \$Id\$ */
+
+/*
+ * Generated by tools/utf8-width.pl from Unicode $version. Do not edit.
+ */
+
+#include <sys/types.h>
+
+#include "tmux.h"
+
+/* Block of widths for each $block code points. */
+const u_char utf8_width_index[UTF8_WIDTH_INDEX] = {
+END
+for (my $i = 0; $i < @index; $i += 12) {
+	my $last = $i + 11 < $#index ? $i + 11 : $#index;
+	print "\t", join(', ', map { sprintf "%3u", $_ } @index[$i .. $last]),
+	    ",\n";
+}
+print <<"END";
+};
+
+/* Widths, two bits for each code point starting from the lowest bits. */
+const u_char utf8_width_blocks[][UTF8_WIDTH_BLOCK] = {
+END
+for my $bytes (@blocks) {
+	print "\t{\n";
+	for (my $i = 0; $i < @$bytes; $i += 8) {
+		print "\t\t", join(', ',
+		    map { sprintf "0x%02x", $_ } @$bytes[$i .. $i + 7]), ",\n";
+	}
+	print "\t},\n";
+}
+print "};\n";
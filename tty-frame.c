@@ -0,0 +1,617 @@
+/* $Id$ */
+
+/*
+ * Copyright (c) 2010 Nicholas Marriott <nicm@users.sourceforge.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF MIND, USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING
+ * OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sys/types.h>
+
+#include <string.h>
+
+#include "tmux.h"
+
+/*
+ * Copy of what is on the terminal.
+ *
+ * Each printable character written by tty_putc or tty_pututf8 is recorded in
+ * the frame at the position it lands, with the attributes the terminal was
+ * using, and the codes which clear, insert, delete or scroll are applied to it
+ * as they are sent. Redrawing compares each cell with the frame and skips
+ * those already correct, so switching windows or redrawing a mostly unchanged
+ * pane or status line sends only what differs.
+ *
+ * Cells which cannot be relied on (after a resize, or where part of a wide
+ * character was overwritten) are marked unknown and never match. The rows are
+ * kept as pointers so scrolling only moves them around.
+ *
+ * Terminals of the same size found to show the same thing share one frame,
+ * which is copied by whichever is next changed on its own.
+ */
+
+struct tty_frame *tty_frame_create(u_int, u_int);
+void	tty_frame_release(struct tty *);
+void	tty_frame_own(struct tty *);
+int	tty_frame_equal(struct tty *, struct tty *);
+struct tty_frame_cell *tty_frame_get(struct tty *, u_int, u_int);
+void	tty_frame_fill(struct tty *, struct tty_frame_cell *, u_int);
+void	tty_frame_fix(struct tty *, u_int, u_int);
+void	tty_frame_scroll(struct tty *, u_int, u_int, u_int, int);
+int	tty_frame_position(struct tty *, u_int *, u_int *);
+
+/* Create a frame with nothing known. */
+struct tty_frame *
+tty_frame_create(u_int sx, u_int sy)
+{
+	struct tty_frame	*frame;
+	u_int			 i;
+
+	frame = xmalloc(sizeof *frame);
+	frame->references = 1;
+
+	frame->data = xcalloc(sx * sy, sizeof *frame->data);
+	frame->rows = xcalloc(sy, sizeof *frame->rows);
+	for (i = 0; i < sy; i++)
+		frame->rows[i] = frame->data + i * sx;
+	for (i = 0; i < sx * sy; i++)
+		frame->data[i].cell.flags = TTY_FRAME_UNKNOWN;
+	return (frame);
+}
+
+/* Drop the reference to the frame, freeing it if it is the last. */
+void
+tty_frame_release(struct tty *tty)
+{
+	struct tty_frame	*frame = tty->frame;
+
+	if (frame == NULL)
+		return;
+	tty->frame = NULL;
+
+	if (--frame->references > 0)
+		return;
+	xfree(frame->rows);
+	xfree(frame->data);
+	xfree(frame);
+}
+
+/*
+ * Make sure the frame belongs to this terminal alone before changing it,
+ * copying it if it is shared.
+ */
+void
+tty_frame_own(struct tty *tty)
+{
+	struct tty_frame	*frame = tty->frame;
+	u_int			 i;
+
+	if (frame->references == 1)
+		return;
+	frame->references--;
+
+	tty->frame = tty_frame_create(tty->sx, tty->sy);
+	for (i = 0; i < tty->sy; i++) {
+		memcpy(tty->frame->rows[i],
+		    frame->rows[i], tty->sx * sizeof *frame->data);
+	}
+}
+
+/* Allocate the frame for the current terminal size, with nothing known. */
+void
+tty_frame_resize(struct tty *tty)
+{
+	tty_frame_release(tty);
+
+	/*
+	 * Terminals which wrap early move the cursor in ways that are not
+	 * tracked closely enough to know where characters end up, so they are
+	 * always redrawn in full.
+	 */
+	if (!(tty->flags & TTY_OPENED) || tty->term->flags & TERM_EARLYWRAP)
+		return;
+
+	tty->frame = tty_frame_create(tty->sx, tty->sy);
+}
+
+/* Free the frame. */
+void
+tty_frame_free(struct tty *tty)
+{
+	tty_frame_release(tty);
+}
+
+/* Forget everything, so that the next redraw writes every cell. */
+void
+tty_frame_invalidate(struct tty *tty)
+{
+	u_int	i;
+
+	if (tty->frame == NULL)
+		return;
+	if (tty->frame->references != 1) {
+		tty_frame_release(tty);
+		tty->frame = tty_frame_create(tty->sx, tty->sy);
+		return;
+	}
+	for (i = 0; i < tty->sx * tty->sy; i++)
+		tty->frame->data[i].cell.flags = TTY_FRAME_UNKNOWN;
+}
+
+/* Are two frames the same? Unknown cells match whatever they contain. */
+int
+tty_frame_equal(struct tty *tty, struct tty *other)
+{
+	struct tty_frame_cell	*fc1, *fc2;
+	u_int			 i, j;
+
+	for (j = 0; j < tty->sy; j++) {
+		fc1 = tty->frame->rows[j];
+		fc2 = other->frame->rows[j];
+		for (i = 0; i < tty->sx; i++, fc1++, fc2++) {
+			if (fc1->cell.flags != fc2->cell.flags)
+				return (0);
+			if (fc1->cell.flags & TTY_FRAME_UNKNOWN)
+				continue;
+			if (memcmp(&fc1->cell, &fc2->cell, sizeof fc1->cell))
+				return (0);
+			if (fc1->cell.flags & GRID_FLAG_UTF8 &&
+			    !grid_utf8_compare(&fc1->utf8, &fc2->utf8))
+				return (0);
+		}
+	}
+	return (1);
+}
+
+/*
+ * Share the frame of another terminal of the same size if both are known to
+ * show the same. Commands can then be encoded once for both by tty_write,
+ * until one of them is sent something different and takes its own copy.
+ */
+int
+tty_frame_join(struct tty *tty, struct tty *other)
+{
+	if (tty->frame == NULL || other->frame == NULL)
+		return (0);
+	if (tty->frame == other->frame)
+		return (1);
+	if (tty->sx != other->sx || tty->sy != other->sy)
+		return (0);
+	if (!tty_frame_equal(tty, other))
+		return (0);
+
+	tty_frame_release(tty);
+	tty->frame = other->frame;
+	tty->frame->references++;
+	return (1);
+}
+
+/*
+ * A command is about to be encoded on this terminal for n terminals sharing
+ * its frame, including itself. The others give up their references and take
+ * the frame back with tty_frame_follow afterwards, so it is only copied if it
+ * is shared with anything else.
+ */
+void
+tty_frame_lead(struct tty *tty, u_int n)
+{
+	if (tty->frame != NULL)
+		tty->frame->references -= n - 1;
+}
+
+/* Take the frame of the terminal which encoded a command for this one. */
+void
+tty_frame_follow(struct tty *tty, struct tty *lead)
+{
+	tty->frame = lead->frame;
+	if (tty->frame != NULL)
+		tty->frame->references++;
+}
+
+/* Mark part of a line unknown. */
+void
+tty_frame_unknown(struct tty *tty, u_int px, u_int py, u_int nx)
+{
+	struct tty_frame_cell	*fc;
+
+	if (tty->frame == NULL)
+		return;
+	if (py >= tty->sy) {
+		tty_frame_invalidate(tty);
+		return;
+	}
+	tty_frame_own(tty);
+	if (px >= tty->sx || nx == 0)
+		return;
+	if (nx > tty->sx - px)
+		nx = tty->sx - px;
+
+	tty_frame_fix(tty, px, py);
+	tty_frame_fix(tty, px + nx - 1, py);
+	for (fc = &tty->frame->rows[py][px]; nx > 0; nx--, fc++)
+		fc->cell.flags = TTY_FRAME_UNKNOWN;
+}
+
+/* Get a cell, or NULL if there is no frame or it is off the terminal. */
+struct tty_frame_cell *
+tty_frame_get(struct tty *tty, u_int px, u_int py)
+{
+	if (tty->frame == NULL || px >= tty->sx || py >= tty->sy)
+		return (NULL);
+	return (&tty->frame->rows[py][px]);
+}
+
+/*
+ * Fill cells as cleared by the terminal. This uses the current background
+ * colour, so they are only known to be blank if the attributes are default.
+ */
+void
+tty_frame_fill(struct tty *tty, struct tty_frame_cell *fc, u_int nx)
+{
+	if (memcmp(&tty->cell, &grid_default_cell, sizeof tty->cell) != 0) {
+		for (; nx > 0; nx--, fc++)
+			fc->cell.flags = TTY_FRAME_UNKNOWN;
+		return;
+	}
+	for (; nx > 0; nx--, fc++)
+		memcpy(&fc->cell, &grid_default_cell, sizeof fc->cell);
+}
+
+/*
+ * Prepare to overwrite a cell. If it is part of a wide character, the whole
+ * character is affected so the rest of it is marked unknown.
+ */
+void
+tty_frame_fix(struct tty *tty, u_int px, u_int py)
+{
+	struct tty_frame_cell	*row = tty->frame->rows[py];
+	u_int			 x;
+
+	if (row[px].cell.flags & TTY_FRAME_UNKNOWN)
+		return;
+
+	if (row[px].cell.flags & GRID_FLAG_PADDING) {
+		for (x = px; x > 0; x--) {
+			if (row[x - 1].cell.flags & TTY_FRAME_UNKNOWN)
+				break;
+			if (!(row[x - 1].cell.flags & GRID_FLAG_PADDING)) {
+				row[x - 1].cell.flags = TTY_FRAME_UNKNOWN;
+				break;
+			}
+			row[x - 1].cell.flags = TTY_FRAME_UNKNOWN;
+		}
+	} else if (!(row[px].cell.flags & GRID_FLAG_UTF8))
+		return;
+
+	for (x = px + 1; x < tty->sx; x++) {
+		if (!(row[x].cell.flags & GRID_FLAG_PADDING) ||
+		    row[x].cell.flags & TTY_FRAME_UNKNOWN)
+			break;
+		row[x].cell.flags = TTY_FRAME_UNKNOWN;
+	}
+}
+
+/* Clear part of a line, as for el or el1. */
+void
+tty_frame_clear(struct tty *tty, u_int px, u_int py, u_int nx)
+{
+	if (tty->frame == NULL)
+		return;
+	if (py >= tty->sy) {
+		tty_frame_invalidate(tty);
+		return;
+	}
+	tty_frame_own(tty);
+	if (px >= tty->sx || nx == 0)
+		return;
+	if (nx > tty->sx - px)
+		nx = tty->sx - px;
+
+	tty_frame_fix(tty, px, py);
+	tty_frame_fix(tty, px + nx - 1, py);
+	tty_frame_fill(tty, &tty->frame->rows[py][px], nx);
+}
+
+/* Is part of a line known to be blank? */
+int
+tty_frame_cleared(struct tty *tty, u_int px, u_int py, u_int nx)
+{
+	struct tty_frame_cell	*fc;
+
+	if ((fc = tty_frame_get(tty, px, py)) == NULL)
+		return (0);
+	if (nx > tty->sx - px)
+		nx = tty->sx - px;
+
+	for (; nx > 0; nx--, fc++) {
+		if (memcmp(&fc->cell, &grid_default_cell, sizeof fc->cell) != 0)
+			return (0);
+	}
+	return (1);
+}
+
+/*
+ * Move lines upper to lower up (if up is nonzero) or down by ny, filling the
+ * lines left behind as cleared.
+ */
+void
+tty_frame_scroll(struct tty *tty, u_int upper, u_int lower, u_int ny, int up)
+{
+	struct tty_frame_cell	**rows, *row;
+	u_int			  i, n;
+
+	if (tty->frame == NULL)
+		return;
+	if (upper > lower || lower >= tty->sy) {
+		tty_frame_invalidate(tty);
+		return;
+	}
+	tty_frame_own(tty);
+
+	rows = tty->frame->rows;
+	n = lower - upper;
+	if (ny > n + 1)
+		ny = n + 1;
+
+	for (i = 0; i < ny; i++) {
+		if (up) {
+			row = rows[upper];
+			memmove(rows + upper,
+			    rows + upper + 1, n * sizeof *rows);
+			rows[lower] = row;
+		} else {
+			row = rows[lower];
+			memmove(rows + upper + 1,
+			    rows + upper, n * sizeof *rows);
+			rows[upper] = row;
+		}
+		tty_frame_fill(tty, row, tty->sx);
+	}
+}
+
+/* Apply a linefeed at the cursor. */
+void
+tty_frame_linefeed(struct tty *tty)
+{
+	if (tty->frame == NULL)
+		return;
+
+	if (tty->cy == tty->rlower)
+		tty_frame_scroll(tty, tty->rupper, tty->rlower, 1, 1);
+	else if (tty->cy >= tty->sy ||
+	    (tty->rlower >= tty->sy && tty->cy == tty->sy - 1)) {
+		/* Cursor or scroll region unknown. */
+		tty_frame_invalidate(tty);
+	}
+}
+
+/* Apply a code which changes the screen contents. */
+void
+tty_frame_code(struct tty *tty, enum tty_code_code code, u_int n)
+{
+	u_int	i;
+
+	if (tty->frame == NULL || !tty_term_has(tty->term, code))
+		return;
+
+	/*
+	 * Only take a copy of a shared frame for codes which change cells:
+	 * cursor movement and attributes leave it as it is.
+	 */
+	switch (code) {
+	case TTYC_CLEAR:
+		tty_frame_own(tty);
+		for (i = 0; i < tty->sy; i++)
+			tty_frame_fill(tty, tty->frame->rows[i], tty->sx);
+		break;
+	case TTYC_EL:
+		if (tty->cx >= tty->sx)
+			tty_frame_clear(tty, tty->sx - 1, tty->cy, 1);
+		else
+			tty_frame_clear(tty, tty->cx, tty->cy, tty->sx);
+		break;
+	case TTYC_EL1:
+		tty_frame_clear(tty, 0, tty->cy, tty->cx + 1);
+		break;
+	case TTYC_ICH:
+	case TTYC_ICH1:
+	case TTYC_DCH:
+	case TTYC_DCH1:
+	case TTYC_SMIR:
+		tty_frame_unknown(tty, tty->cx, tty->cy, tty->sx);
+		break;
+	case TTYC_IL:
+	case TTYC_IL1:
+	case TTYC_DL:
+	case TTYC_DL1:
+		if (tty->rlower >= tty->sy || tty->cy >= tty->sy) {
+			tty_frame_invalidate(tty);
+			break;
+		}
+		if (tty->cy < tty->rupper || tty->cy > tty->rlower)
+			break;
+		tty_frame_scroll(tty, tty->cy, tty->rlower, n,
+		    code == TTYC_DL || code == TTYC_DL1);
+		break;
+	case TTYC_RI:
+		if (tty->cy == tty->rupper)
+			tty_frame_scroll(tty, tty->rupper, tty->rlower, 1, 0);
+		else if (tty->cy >= tty->sy || tty->rupper >= tty->sy)
+			tty_frame_invalidate(tty);
+		break;
+	case TTYC_INDN:
+		tty_frame_scroll(tty, tty->rupper, tty->rlower, n, 1);
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * Work out where the next character written will go. If the cursor is past
+ * the end of the line, it wraps first. Returns 0 if this is not known.
+ */
+int
+tty_frame_position(struct tty *tty, u_int *px, u_int *py)
+{
+	*px = tty->cx;
+	*py = tty->cy;
+
+	if (*py >= tty->sy) {
+		tty_frame_invalidate(tty);
+		return (0);
+	}
+	if (*px >= tty->sx) {
+		tty_frame_linefeed(tty);
+		*px = 0;
+		if (*py != tty->rlower)
+			(*py)++;
+	}
+	if (*py >= tty->sy) {
+		tty_frame_invalidate(tty);
+		return (0);
+	}
+	return (1);
+}
+
+/* Record a character written at the cursor. */
+void
+tty_frame_putc(struct tty *tty, u_char ch)
+{
+	struct tty_frame_cell	*fc;
+	u_int			 px, py;
+
+	if (tty->frame == NULL)
+		return;
+	tty_frame_own(tty);
+	if (!tty_frame_position(tty, &px, &py))
+		return;
+
+	tty_frame_fix(tty, px, py);
+	fc = &tty->frame->rows[py][px];
+	memcpy(&fc->cell, &tty->cell, sizeof fc->cell);
+	fc->cell.flags &= (GRID_FLAG_FG256|GRID_FLAG_BG256);
+	fc->cell.data = ch;
+}
+
+/* Record a run of characters written at the cursor, not passing the edge. */
+void
+tty_frame_putn(struct tty *tty, const u_char *buf, u_int n)
+{
+	struct tty_frame_cell	*fc;
+	u_int			 i;
+
+	if (tty->frame == NULL)
+		return;
+	tty_frame_own(tty);
+	if (tty->cy >= tty->sy ||
+	    tty->cx >= tty->sx || n > tty->sx - tty->cx) {
+		tty_frame_invalidate(tty);
+		return;
+	}
+
+	tty_frame_fix(tty, tty->cx, tty->cy);
+	tty_frame_fix(tty, tty->cx + n - 1, tty->cy);
+	fc = &tty->frame->rows[tty->cy][tty->cx];
+	for (i = 0; i < n; i++, fc++) {
+		memcpy(&fc->cell, &tty->cell, sizeof fc->cell);
+		fc->cell.flags &= (GRID_FLAG_FG256|GRID_FLAG_BG256);
+		fc->cell.data = buf[i];
+	}
+}
+
+/* Record a UTF-8 character written at the cursor. */
+void
+tty_frame_pututf8(struct tty *tty, const struct grid_utf8 *gu)
+{
+	struct tty_frame_cell	*fc;
+	u_int			 px, py, i;
+
+	if (tty->frame == NULL)
+		return;
+	tty_frame_own(tty);
+	if (!tty_frame_position(tty, &px, &py))
+		return;
+
+	/* Zero width may combine with the previous cell. */
+	if (gu->width == 0) {
+		if (px != 0)
+			px--;
+		tty_frame_unknown(tty, px, py, 2);
+		return;
+	}
+	if (px + gu->width > tty->sx) {
+		tty_frame_invalidate(tty);
+		return;
+	}
+
+	for (i = 0; i < gu->width; i++)
+		tty_frame_fix(tty, px + i, py);
+	fc = &tty->frame->rows[py][px];
+	memcpy(&fc->cell, &tty->cell, sizeof fc->cell);
+	fc->cell.flags &= (GRID_FLAG_FG256|GRID_FLAG_BG256);
+	fc->cell.flags |= GRID_FLAG_UTF8;
+	memcpy(&fc->utf8, gu, sizeof fc->utf8);
+	for (i = 1; i < gu->width; i++) {
+		memcpy(&fc[i].cell, &fc->cell, sizeof fc[i].cell);
+		fc[i].cell.flags &= ~GRID_FLAG_UTF8;
+		fc[i].cell.flags |= GRID_FLAG_PADDING;
+	}
+}
+
+/*
+ * Is a cell already on the terminal? Like tty_attributes, the foreground
+ * colour of a space (or the background if it is reversed) is not important.
+ */
+int
+tty_frame_same(struct tty *tty,
+    u_int px, u_int py, const struct grid_cell *gc, const struct grid_utf8 *gu)
+{
+	const struct tty_frame_cell	*fc;
+	u_char				 flags;
+
+	if ((fc = tty_frame_get(tty, px, py)) == NULL)
+		return (0);
+	flags = fc->cell.flags;
+	if (flags & TTY_FRAME_UNKNOWN)
+		return (0);
+
+	if (gc->flags & GRID_FLAG_PADDING)
+		return (flags & GRID_FLAG_PADDING);
+	if (flags & GRID_FLAG_PADDING)
+		return (0);
+
+	if (gc->flags & GRID_FLAG_UTF8) {
+		if (!(flags & GRID_FLAG_UTF8))
+			return (0);
+		if (!grid_utf8_compare(&fc->utf8, gu))
+			return (0);
+	} else if (flags & GRID_FLAG_UTF8 || fc->cell.data != gc->data)
+		return (0);
+
+	if (fc->cell.attr != gc->attr)
+		return (0);
+	flags ^= gc->flags;
+
+	if (gc->data != ' ' || gc->flags & GRID_FLAG_UTF8 ||
+	    gc->attr & GRID_ATTR_REVERSE) {
+		if (fc->cell.fg != gc->fg || flags & GRID_FLAG_FG256)
+			return (0);
+	}
+	if (gc->data != ' ' || gc->flags & GRID_FLAG_UTF8 ||
+	    !(gc->attr & GRID_ATTR_REVERSE)) {
+		if (fc->cell.bg != gc->bg || flags & GRID_FLAG_BG256)
+			return (0);
+	}
+	return (1);
+}
@@ -529,7 +529,7 @@ partial_key:
 
 start_timer:
 	/* Start the timer and wait for expiry or more data. */
-	delay = options_get_number(&global_options, "escape-time");
+	delay = options_number(&global_options, OPTC_ESCAPE_TIME);
 	tv.tv_sec = delay / 1000;
 	tv.tv_usec = (delay % 1000) * 1000L;
 
@@ -69,6 +69,7 @@ struct tty_term_code_entry tty_term_codes[NTTYCODE] = {
 	{ TTYC_ICH1, TTYCODE_STRING, "ich1" },
 	{ TTYC_IL, TTYCODE_STRING, "il" },
 	{ TTYC_IL1, TTYCODE_STRING, "il1" },
+	{ TTYC_INDN, TTYCODE_STRING, "indn" },
 	{ TTYC_INVIS, TTYCODE_STRING, "invis" },
 	{ TTYC_IS1, TTYCODE_STRING, "is1" },
 	{ TTYC_IS2, TTYCODE_STRING, "is2" },
@@ -45,6 +45,22 @@ void	tty_emulate_repeat(
 	    struct tty *, enum tty_code_code, enum tty_code_code, u_int);
 void	tty_cell(struct tty *,
 	    const struct grid_cell *, const struct grid_utf8 *);
+void	tty_putcells(struct tty *, const u_char *, u_int);
+void	tty_add(struct tty *, const void *, size_t);
+int	tty_same(struct tty *, struct tty *);
+void	tty_follow(struct tty *, struct tty *, size_t);
+
+/*
+ * Terminal to be sent a command by tty_write. Terminals in the same state are
+ * grouped and the command is encoded only for the first, the lead.
+ */
+struct tty_write_entry {
+	struct tty	*tty;
+	u_int		 lead;		/* entry which encodes it */
+	u_int		 members;	/* size of group, if lead */
+	size_t		 off;		/* output start, if lead */
+};
+ARRAY_DECL(, struct tty_write_entry) tty_write_list;
 
 void
 tty_init(struct tty *tty, int fd, char *term)
@@ -84,6 +100,7 @@ tty_resize(struct tty *tty)
 		tty->sx = 80;
 	if (tty->sy == 0)
 		tty->sy = 24;
+	tty_frame_resize(tty);
 
 	tty->cx = UINT_MAX;
 	tty->cy = UINT_MAX;
@@ -172,6 +189,7 @@ tty_start_tty(struct tty *tty)
 		fatal("tcsetattr failed");
 	tcflush(tty->fd, TCIOFLUSH);
 
+	tty_frame_resize(tty);
 	tty_putcode(tty, TTYC_SMCUP);
 
 	tty_putcode(tty, TTYC_SGR0);
@@ -204,6 +222,7 @@ tty_stop_tty(struct tty *tty)
 
 	if (!(tty->flags & TTY_STARTED))
 		return;
+	tty_flush(tty);
 	tty->flags &= ~TTY_STARTED;
 
 	bufferevent_disable(tty->event, EV_READ|EV_WRITE);
@@ -268,6 +287,7 @@ tty_close(struct tty *tty)
 
 	evtimer_del(&tty->key_timer);
 	tty_stop_tty(tty);
+	tty->olen = 0;
 
 	if (tty->flags & TTY_OPENED) {
 		bufferevent_free(tty->event);
@@ -289,6 +309,9 @@ tty_free(struct tty *tty)
 {
 	tty_close(tty);
 
+	tty_frame_free(tty);
+	if (tty->obuf != NULL)
+		xfree(tty->obuf);
 	if (tty->path != NULL)
 		xfree(tty->path);
 	if (tty->termname != NULL)
@@ -305,6 +328,7 @@ void
 tty_putcode(struct tty *tty, enum tty_code_code code)
 {
 	tty_puts(tty, tty_term_string(tty->term, code));
+	tty_frame_code(tty, code, 1);
 }
 
 void
@@ -313,6 +337,7 @@ tty_putcode1(struct tty *tty, enum tty_code_code code, int a)
 	if (a < 0)
 		return;
 	tty_puts(tty, tty_term_string1(tty->term, code, a));
+	tty_frame_code(tty, code, a);
 }
 
 void
@@ -323,27 +348,79 @@ tty_putcode2(struct tty *tty, enum tty_code_code code, int a, int b)
 	tty_puts(tty, tty_term_string2(tty->term, code, a, b));
 }
 
+/*
+ * Output is collected in a flat buffer in the tty and handed on once each time
+ * around the server loop by tty_flush, rather than added to the bufferevent a
+ * few bytes at a time.
+ */
 void
-tty_puts(struct tty *tty, const char *s)
+tty_add(struct tty *tty, const void *buf, size_t len)
 {
-	if (*s == '\0')
+	if (tty->osize - tty->olen < len) {
+		if (tty->osize == 0)
+			tty->osize = TTY_OUTSIZE;
+		while (tty->osize - tty->olen < len)
+			tty->osize *= 2;
+		tty->obuf = xrealloc(tty->obuf, 1, tty->osize);
+	}
+	memcpy(tty->obuf + tty->olen, buf, len);
+	tty->olen += len;
+}
+
+/*
+ * Pass buffered output to the terminal. If nothing is already waiting in the
+ * bufferevent, it is written straight away, and only what the terminal won't
+ * take yet is left for the bufferevent.
+ */
+void
+tty_flush(struct tty *tty)
+{
+	ssize_t	n;
+
+	if (tty->olen == 0)
 		return;
-	bufferevent_write(tty->event, s, strlen(s));
 
 	if (tty->log_fd != -1)
-		write(tty->log_fd, s, strlen(s));
+		write(tty->log_fd, tty->obuf, tty->olen);
+
+	n = 0;
+	if (tty->flags & TTY_STARTED &&
+	    EVBUFFER_LENGTH(tty->event->output) == 0) {
+		if ((n = write(tty->fd, tty->obuf, tty->olen)) == -1)
+			n = 0;
+	}
+	if ((size_t) n < tty->olen)
+		bufferevent_write(tty->event, tty->obuf + n, tty->olen - n);
+	tty->olen = 0;
+}
+
+void
+tty_puts(struct tty *tty, const char *s)
+{
+	if (*s == '\0')
+		return;
+	tty_add(tty, s, strlen(s));
 }
 
 void
 tty_putc(struct tty *tty, u_char ch)
 {
+	u_char	out;
 	u_int	sx;
 
+	out = ch;
 	if (tty->cell.attr & GRID_ATTR_CHARSET)
-		ch = tty_get_acs(tty, ch);
-	bufferevent_write(tty->event, &ch, 1);
+		out = tty_get_acs(tty, ch);
+	if (tty->olen != tty->osize)
+		tty->obuf[tty->olen++] = out;
+	else
+		tty_add(tty, &out, 1);
+
+	if (out == '\n')
+		tty_frame_linefeed(tty);
+	else if (out >= 0x20 && out != 0x7f) {
+		tty_frame_putc(tty, ch);
 
-	if (ch >= 0x20 && ch != 0x7f) {
 		sx = tty->sx;
 		if (tty->term->flags & TERM_EARLYWRAP)
 			sx--;
@@ -355,9 +432,6 @@ tty_putc(struct tty *tty, u_char ch)
 		} else
 			tty->cx++;
 	}
-
-	if (tty->log_fd != -1)
-		write(tty->log_fd, &ch, 1);
 }
 
 void
@@ -366,9 +440,8 @@ tty_pututf8(struct tty *tty, const struct grid_utf8 *gu)
 	size_t	size;
 
 	size = grid_utf8_size(gu);
-	bufferevent_write(tty->event, gu->data, size);
-	if (tty->log_fd != -1)
-		write(tty->log_fd, gu->data, size);
+	tty_add(tty, gu->data, size);
+	tty_frame_pututf8(tty, gu);
 	tty->cx += gu->width;
 }
 
@@ -463,37 +536,47 @@ void
 tty_draw_line(struct tty *tty, struct screen *s, u_int py, u_int ox, u_int oy)
 {
 	const struct grid_cell	*gc;
-	struct grid_line	*gl;
+	const struct grid_line	*gl;
 	struct grid_cell	 tmpgc;
 	const struct grid_utf8	*gu;
 	u_int			 i, sx;
+	int			 move;
 
 	tty_update_mode(tty, tty->mode & ~MODE_CURSOR);
 
 	sx = screen_size_x(s);
-	if (sx > s->grid->linedata[s->grid->hsize + py].cellsize)
-		sx = s->grid->linedata[s->grid->hsize + py].cellsize;
+	gl = grid_peek_line(s->grid, s->grid->hsize + py);
+	if (sx > gl->cellsize)
+		sx = gl->cellsize;
 	if (sx > tty->sx)
 		sx = tty->sx;
 
 	/*
 	 * Don't move the cursor to the start permission if it will wrap there
-	 * itself.
+	 * itself. This is only the case if the pane is the full width and the
+	 * cursor is at the end of the line before, or at the end of this one
+	 * at the bottom of the scroll region.
 	 */
 	gl = NULL;
 	if (py != 0)
-		gl = &s->grid->linedata[s->grid->hsize + py - 1];
-	if (oy + py == 0 || gl == NULL || !(gl->flags & GRID_LINE_WRAPPED) ||
-	    tty->cx < tty->sx || ox != 0 ||
-	    (oy + py != tty->cy + 1 && tty->cy != s->rlower + oy))
-		tty_cursor(tty, ox, oy + py);
+		gl = grid_peek_line(s->grid, s->grid->hsize + py - 1);
+	move = (oy + py == 0 || gl == NULL ||
+	    !(gl->flags & GRID_LINE_WRAPPED) || tty->cx < tty->sx || ox != 0 ||
+	    screen_size_x(s) < tty->sx || (oy + py != tty->cy + 1 &&
+	    (oy + py != tty->cy || tty->cy != tty->rlower)));
 
+	/*
+	 * Cells already on the terminal are skipped, and the cursor moved
+	 * to the next one that isn't. If the cursor is going to wrap to the
+	 * start, the first cell is always written so it does.
+	 */
 	for (i = 0; i < sx; i++) {
-		gc = grid_view_peek_cell(s->grid, i, py);
+		gc = grid_peek_cell_unchecked(s->grid, i, s->grid->hsize + py);
 
 		gu = NULL;
 		if (gc->flags & GRID_FLAG_UTF8)
-			gu = grid_view_peek_utf8(s->grid, i, py);
+			gu = grid_peek_utf8_unchecked(
+			    s->grid, i, s->grid->hsize + py);
 
 		if (screen_check_selection(s, i, py)) {
 			memcpy(&tmpgc, &s->sel.cell, sizeof tmpgc);
@@ -502,12 +585,23 @@ tty_draw_line(struct tty *tty, struct screen *s, u_int py, u_int ox, u_int oy)
 			    ~(GRID_FLAG_FG256|GRID_FLAG_BG256);
 			tmpgc.flags |= s->sel.cell.flags &
 			    (GRID_FLAG_FG256|GRID_FLAG_BG256);
-			tty_cell(tty, &tmpgc, gu);
-		} else
-			tty_cell(tty, gc, gu);
+			gc = &tmpgc;
+		}
+
+		if ((i != 0 || move) &&
+		    tty_frame_same(tty, ox + i, oy + py, gc, gu)) {
+			move = 1;
+			continue;
+		}
+		if (move) {
+			tty_cursor(tty, ox + i, oy + py);
+			move = 0;
+		}
+		tty_cell(tty, gc, gu);
 	}
 
-	if (sx >= tty->sx) {
+	if (sx >= tty->sx ||
+	    tty_frame_cleared(tty, ox + sx, oy + py, screen_size_x(s) - sx)) {
 		tty_update_mode(tty, tty->mode);
 		return;
 	}
@@ -529,7 +623,8 @@ tty_write(void (*cmdfn)(
 {
 	struct window_pane	*wp = ctx->wp;
 	struct client		*c;
-	u_int		 	 i;
+	struct tty_write_entry	 entry, *ent, *lead;
+	u_int		 	 i, j;
 
 	/* wp can be NULL if updating the screen but not the terminal. */
 	if (wp == NULL)
@@ -550,9 +645,93 @@ tty_write(void (*cmdfn)(
 		if (c->session->curw->window == wp->window) {
 			if (c->tty.flags & TTY_FREEZE || c->tty.term == NULL)
 				continue;
-			cmdfn(&c->tty, ctx);
+
+			/*
+			 * If the next frame isn't due yet or the client is
+			 * behind, just remember the pane has changed. It is
+			 * drawn from the screen once the client can take it,
+			 * so a dropped frame is counted only the first time.
+			 */
+			if (c->flags & (CLIENT_RENDERWAIT|CLIENT_BACKOFF)) {
+				if ((c->flags & (CLIENT_BACKOFF|CLIENT_DAMAGED))
+				    == CLIENT_BACKOFF)
+					c->dropped++;
+				c->flags |= CLIENT_DAMAGED;
+				continue;
+			}
+
+			entry.tty = &c->tty;
+			entry.lead = ARRAY_LENGTH(&tty_write_list);
+			entry.members = 1;
+			for (j = 0; j < ARRAY_LENGTH(&tty_write_list); j++) {
+				lead = &ARRAY_ITEM(&tty_write_list, j);
+				if (lead->lead != j)
+					continue;
+				if (!tty_same(lead->tty, entry.tty))
+					continue;
+				entry.lead = j;
+				lead->members++;
+				break;
+			}
+			ARRAY_ADD(&tty_write_list, entry);
 		}
 	}
+
+	/*
+	 * Encode the command once for each group and give the output to the
+	 * rest of its members. Clients watching the same session usually share
+	 * a frame and state, so this scales with the number of distinct
+	 * terminals rather than clients.
+	 */
+	for (i = 0; i < ARRAY_LENGTH(&tty_write_list); i++) {
+		ent = &ARRAY_ITEM(&tty_write_list, i);
+		lead = &ARRAY_ITEM(&tty_write_list, ent->lead);
+		if (ent != lead) {
+			tty_follow(ent->tty, lead->tty, lead->off);
+			continue;
+		}
+
+		tty_frame_lead(ent->tty, ent->members);
+		ent->off = ent->tty->olen;
+		cmdfn(ent->tty, ctx);
+	}
+	ARRAY_CLEAR(&tty_write_list);
+}
+
+/* Could a command be encoded once for both terminals? */
+int
+tty_same(struct tty *tty, struct tty *other)
+{
+	if (tty->frame != other->frame || tty->term != other->term)
+		return (0);
+	if (tty->sx != other->sx || tty->sy != other->sy)
+		return (0);
+	if (tty->cx != other->cx || tty->cy != other->cy)
+		return (0);
+	if (tty->rupper != other->rupper || tty->rlower != other->rlower)
+		return (0);
+	if (tty->mode != other->mode || tty->term_flags != other->term_flags)
+		return (0);
+	if ((tty->flags ^ other->flags) & (TTY_NOCURSOR|TTY_UTF8))
+		return (0);
+	return (memcmp(&tty->cell, &other->cell, sizeof tty->cell) == 0);
+}
+
+/* Give a terminal the output a command produced for another, and its state. */
+void
+tty_follow(struct tty *tty, struct tty *lead, size_t off)
+{
+	if (lead->olen != off)
+		tty_add(tty, lead->obuf + off, lead->olen - off);
+
+	tty->cx = lead->cx;
+	tty->cy = lead->cy;
+	tty->rupper = lead->rupper;
+	tty->rlower = lead->rlower;
+	tty->mode = lead->mode;
+	memcpy(&tty->cell, &lead->cell, sizeof tty->cell);
+
+	tty_frame_follow(tty, lead);
 }
 
 void
@@ -761,6 +940,42 @@ tty_cmd_linefeed(struct tty *tty, const struct tty_ctx *ctx)
 	tty_putc(tty, '\n');
 }
 
+/*
+ * Scroll the region up by ctx->num lines, for a run of linefeeds at the bottom
+ * of the region. Use parm_index if there is more than one and the terminal
+ * has it, otherwise a newline for each line.
+ */
+void
+tty_cmd_scrollup(struct tty *tty, const struct tty_ctx *ctx)
+{
+	struct window_pane	*wp = ctx->wp;
+	struct screen		*s = wp->screen;
+	u_int			 i, ny;
+
+	if (wp->xoff != 0 || screen_size_x(s) < tty->sx ||
+	    !tty_term_has(tty->term, TTYC_CSR)) {
+		tty_redraw_region(tty, ctx);
+		return;
+	}
+
+	/* Scrolling more than the whole region just clears it. */
+	ny = ctx->num;
+	if (ny > ctx->orlower - ctx->orupper + 1)
+		ny = ctx->orlower - ctx->orupper + 1;
+
+	tty_reset(tty);
+
+	tty_region_pane(tty, ctx, ctx->orupper, ctx->orlower);
+	tty_cursor_pane(tty, ctx, ctx->ocx, ctx->orlower);
+
+	if (ny > 1 && tty_term_has(tty->term, TTYC_INDN))
+		tty_putcode1(tty, TTYC_INDN, ny);
+	else {
+		for (i = 0; i < ny; i++)
+			tty_putc(tty, '\n');
+	}
+}
+
 void
 tty_cmd_clearendofscreen(struct tty *tty, const struct tty_ctx *ctx)
 {
@@ -902,12 +1117,88 @@ tty_cmd_cell(struct tty *tty, const struct tty_ctx *ctx)
 			tty_cursor_pane(tty, ctx, cx, ctx->ocy);
 			tty_cell(tty, &ctx->last_cell, &ctx->last_utf8);
 		}
-	} else
+	} else {
+		if (tty_frame_same(tty, wp->xoff + ctx->ocx,
+		    wp->yoff + ctx->ocy, ctx->cell, ctx->utf8))
+			return;
 		tty_cursor_pane(tty, ctx, ctx->ocx, ctx->ocy);
+	}
 
 	tty_cell(tty, ctx->cell, ctx->utf8);
 }
 
+/*
+ * Write a run of narrow characters with the same attributes, all on one line
+ * and not at the end of it.
+ */
+void
+tty_cmd_cells(struct tty *tty, const struct tty_ctx *ctx)
+{
+	struct window_pane	*wp = ctx->wp;
+	const u_char		*buf = ctx->ptr;
+	struct grid_cell	 gc;
+	u_int			 i, n, px, py;
+
+	tty_region_pane(tty, ctx, ctx->orupper, ctx->orlower);
+
+	px = wp->xoff + ctx->ocx;
+	py = wp->yoff + ctx->ocy;
+
+	memcpy(&gc, ctx->cell, sizeof gc);
+	for (i = 0; i < ctx->num; i += n) {
+		/* Skip characters already on the terminal. */
+		gc.data = buf[i];
+		if (tty_frame_same(tty, px + i, py, &gc, NULL)) {
+			n = 1;
+			continue;
+		}
+
+		/*
+		 * Spaces do not need the foreground colour, so the attributes
+		 * are set for each run of spaces or of other characters.
+		 */
+		for (n = 1; i + n < ctx->num; n++) {
+			if ((buf[i + n] == ' ') != (buf[i] == ' '))
+				break;
+			gc.data = buf[i + n];
+			if (tty_frame_same(tty, px + i + n, py, &gc, NULL))
+				break;
+		}
+		gc.data = buf[i];
+		tty_cursor(tty, px + i, py);
+		tty_attributes(tty, &gc);
+
+		/*
+		 * Characters which may need translating or may be skipped at
+		 * the end of the screen go one at a time, otherwise the whole
+		 * run is written at once. It cannot pass the edge of the
+		 * terminal.
+		 */
+		if (tty->cell.attr & GRID_ATTR_CHARSET ||
+		    tty->term->flags & TERM_EARLYWRAP || tty->cx + n > tty->sx) {
+			tty_putcells(tty, buf + i, n);
+			continue;
+		}
+		tty_add(tty, buf + i, n);
+		tty_frame_putn(tty, buf + i, n);
+		tty->cx += n;
+	}
+}
+
+/* Write characters one at a time, like tty_cell. */
+void
+tty_putcells(struct tty *tty, const u_char *buf, u_int n)
+{
+	u_int	i;
+
+	for (i = 0; i < n; i++) {
+		if (tty->term->flags & TERM_EARLYWRAP &&
+		    tty->cy == tty->sy - 1 && tty->cx == tty->sx - 1)
+			continue;
+		tty_putc(tty, buf[i]);
+	}
+}
+
 void
 tty_cmd_utf8character(struct tty *tty, const struct tty_ctx *ctx)
 {
@@ -1147,6 +1438,18 @@ tty_attributes(struct tty *tty, const struct grid_cell *gc)
 {
 	struct grid_cell	*tc = &tty->cell, gc2;
 	u_char			 changed, new_attr;
+	u_int			 key;
+
+	/*
+	 * Most cells have the same style as the one before, so check for that
+	 * first by comparing style keys. The terminal's cell only ever has the
+	 * colour flags, so the others are masked out of the new cell's key.
+	 * Without setab the reverse hack below may change the style, so always
+	 * go the long way.
+	 */
+	key = grid_style_key(gc) & ~((GRID_FLAG_PADDING|GRID_FLAG_UTF8) << 8);
+	if (key == grid_style_key(tc) && tty_term_has(tty->term, TTYC_SETAB))
+		return;
 
 	/* If the character is space, don't care about foreground. */
 	if (gc->data == ' ' && !(gc->flags & GRID_FLAG_UTF8)) {
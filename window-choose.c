@@ -126,10 +126,10 @@ window_choose_init(struct window_pane *wp)
 	s = &data->screen;
 	screen_init(s, screen_size_x(&wp->base), screen_size_y(&wp->base), 0);
 	s->mode &= ~MODE_CURSOR;
-	if (options_get_number(&wp->window->options, "mode-mouse"))
+	if (options_number(&wp->window->options, OPTC_MODE_MOUSE))
 		s->mode |= MODE_MOUSE;
 
-	keys = options_get_number(&wp->window->options, "mode-keys");
+	keys = options_number(&wp->window->options, OPTC_MODE_KEYS);
 	if (keys == MODEKEY_EMACS)
 		mode_key_init(&data->mdata, &mode_key_tree_emacs_choice);
 	else
@@ -342,12 +342,12 @@ window_choose_write_line(
 	if (data->callbackfn == NULL)
 		fatalx("called before callback assigned");
 
-	utf8flag = options_get_number(&wp->window->options, "utf8");
+	utf8flag = options_number(&wp->window->options, OPTC_UTF8);
 	memcpy(&gc, &grid_default_cell, sizeof gc);
 	if (data->selected == data->top + py) {
-		colour_set_fg(&gc, options_get_number(oo, "mode-fg"));
-		colour_set_bg(&gc, options_get_number(oo, "mode-bg"));
-		gc.attr |= options_get_number(oo, "mode-attr");
+		colour_set_fg(&gc, options_number(oo, OPTC_MODE_FG));
+		colour_set_bg(&gc, options_number(oo, OPTC_MODE_BG));
+		gc.attr |= options_number(oo, OPTC_MODE_ATTR);
 	}
 
 	screen_write_cursormove(ctx, 0, py);
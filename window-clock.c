@@ -115,8 +115,8 @@ window_clock_draw_screen(struct window_pane *wp)
 	struct screen_write_ctx	 	 ctx;
 	int				 colour, style;
 
-	colour = options_get_number(&wp->window->options, "clock-mode-colour");
-	style = options_get_number(&wp->window->options, "clock-mode-style");
+	colour = options_number(&wp->window->options, OPTC_CLOCK_MODE_COLOUR);
+	style = options_number(&wp->window->options, OPTC_CLOCK_MODE_STYLE);
 
 	screen_write_start(&ctx, NULL, &data->screen);
 	clock_draw(&ctx, colour, style);
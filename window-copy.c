@@ -144,10 +144,10 @@ window_copy_init(struct window_pane *wp)
 
 	s = &data->screen;
 	screen_init(s, screen_size_x(&wp->base), screen_size_y(&wp->base), 0);
-	if (options_get_number(&wp->window->options, "mode-mouse"))
+	if (window_cache(wp->window)->mode_mouse)
 		s->mode |= MODE_MOUSE;
 
-	keys = options_get_number(&wp->window->options, "mode-keys");
+	keys = window_cache(wp->window)->mode_keys;
 	if (keys == MODEKEY_EMACS)
 		mode_key_init(&data->mdata, &mode_key_tree_emacs_copy);
 	else
@@ -357,12 +357,12 @@ window_copy_key(struct window_pane *wp, struct client *c, int key)
 		break;
 	case MODEKEYCOPY_NEXTWORD:
 		word_separators =
-		    options_get_string(&wp->window->options, "word-separators");
+		    options_string(&wp->window->options, OPTC_WORD_SEPARATORS);
 		window_copy_cursor_next_word(wp, word_separators);
 		break;
 	case MODEKEYCOPY_NEXTWORDEND:
 		word_separators =
-		    options_get_string(&wp->window->options, "word-separators");
+		    options_string(&wp->window->options, OPTC_WORD_SEPARATORS);
 		window_copy_cursor_next_word_end(wp, word_separators);
 		break;
 	case MODEKEYCOPY_PREVIOUSSPACE:
@@ -370,7 +370,7 @@ window_copy_key(struct window_pane *wp, struct client *c, int key)
 		break;
 	case MODEKEYCOPY_PREVIOUSWORD:
 		word_separators =
-		    options_get_string(&wp->window->options, "word-separators");
+		    options_string(&wp->window->options, OPTC_WORD_SEPARATORS);
 		window_copy_cursor_previous_word(wp, word_separators);
 		break;
 	case MODEKEYCOPY_SEARCHUP:
@@ -416,7 +416,7 @@ window_copy_key(struct window_pane *wp, struct client *c, int key)
 	return;
 
 input_on:
-	keys = options_get_number(&wp->window->options, "mode-keys");
+	keys = window_cache(wp->window)->mode_keys;
 	if (keys == MODEKEY_EMACS)
 		mode_key_init(&data->mdata, &mode_key_tree_emacs_edit);
 	else
@@ -426,7 +426,7 @@ input_on:
 	return;
 
 input_off:
-	keys = options_get_number(&wp->window->options, "mode-keys");
+	keys = window_cache(wp->window)->mode_keys;
 	if (keys == MODEKEY_EMACS)
 		mode_key_init(&data->mdata, &mode_key_tree_emacs_copy);
 	else
@@ -623,7 +623,7 @@ window_copy_search_up(struct window_pane *wp, const char *searchstr)
 
 	if (*searchstr == '\0')
 		return;
-	utf8flag = options_get_number(&wp->window->options, "utf8");
+	utf8flag = options_number(&wp->window->options, OPTC_UTF8);
 	searchlen = screen_write_strlen(utf8flag, "%s", searchstr);
 
 	screen_init(&ss, searchlen, 1, 0);
@@ -680,7 +680,7 @@ window_copy_search_down(struct window_pane *wp, const char *searchstr)
 
 	if (*searchstr == '\0')
 		return;
-	utf8flag = options_get_number(&wp->window->options, "utf8");
+	utf8flag = options_number(&wp->window->options, OPTC_UTF8);
 	searchlen = screen_write_strlen(utf8flag, "%s", searchstr);
 
 	screen_init(&ss, searchlen, 1, 0);
@@ -745,15 +745,11 @@ window_copy_write_line(
 {
 	struct window_copy_mode_data	*data = wp->modedata;
 	struct screen			*s = &data->screen;
-	struct options			*oo = &wp->window->options;
 	struct grid_cell		 gc;
 	char				 hdr[32];
 	size_t	 			 last, xoff = 0, size = 0;
 
-	memcpy(&gc, &grid_default_cell, sizeof gc);
-	colour_set_fg(&gc, options_get_number(oo, "mode-fg"));
-	colour_set_bg(&gc, options_get_number(oo, "mode-bg"));
-	gc.attr |= options_get_number(oo, "mode-attr");
+	memcpy(&gc, &window_cache(wp->window)->mode_gc, sizeof gc);
 
 	last = screen_size_y(s) - 1;
 	if (py == 0) {
@@ -851,7 +847,6 @@ window_copy_update_selection(struct window_pane *wp)
 {
 	struct window_copy_mode_data	*data = wp->modedata;
 	struct screen			*s = &data->screen;
-	struct options			*oo = &wp->window->options;
 	struct grid_cell		 gc;
 	u_int				 sx, sy, ty, cy;
 
@@ -859,10 +854,7 @@ window_copy_update_selection(struct window_pane *wp)
 		return (0);
 
 	/* Set colours. */
-	memcpy(&gc, &grid_default_cell, sizeof gc);
-	colour_set_fg(&gc, options_get_number(oo, "mode-fg"));
-	colour_set_bg(&gc, options_get_number(oo, "mode-bg"));
-	gc.attr |= options_get_number(oo, "mode-attr");
+	memcpy(&gc, &window_cache(wp->window)->mode_gc, sizeof gc);
 
 	/* Find top of screen. */
 	ty = screen_hsize(&wp->base) - data->oy;
@@ -997,7 +989,7 @@ window_copy_copy_selection(struct window_pane *wp, struct client *c)
 	off--;	/* remove final \n */
 
 	/* Add the buffer to the stack. */
-	limit = options_get_number(&c->session->options, "buffer-limit");
+	limit = options_number(&c->session->options, OPTC_BUFFER_LIMIT);
 	paste_add(&c->session->buffers, buf, off, limit);
 }
 
@@ -1008,7 +1000,7 @@ window_copy_copy_line(struct window_pane *wp,
 	struct grid		*gd = wp->base.grid;
 	const struct grid_cell	*gc;
 	const struct grid_utf8	*gu;
-	struct grid_line	*gl;
+	const struct grid_line	*gl;
 	u_int			 i, xx, wrapped = 0;
 	size_t			 size;
 
@@ -1019,7 +1011,7 @@ window_copy_copy_line(struct window_pane *wp,
 	 * Work out if the line was wrapped at the screen edge and all of it is
 	 * on screen.
 	 */
-	gl = &gd->linedata[sy];
+	gl = grid_peek_line(gd, sy);
 	if (gl->flags & GRID_LINE_WRAPPED && gl->cellsize <= gd->sx)
 		wrapped = 1;
 
@@ -1096,7 +1088,7 @@ window_copy_find_length(struct window_pane *wp, u_int py)
 	 * width of the grid, and screen_write_copy treats them as spaces, so
 	 * ignore them here too.
 	 */
-	px = wp->base.grid->linedata[py].cellsize;
+	px = grid_peek_line(wp->base.grid, py)->cellsize;
 	if (px > screen_size_x(&wp->base))
 		px = screen_size_x(&wp->base);
 	while (px > 0) {
@@ -100,7 +100,7 @@ window_more_init(struct window_pane *wp)
 	screen_init(s, screen_size_x(&wp->base), screen_size_y(&wp->base), 0);
 	s->mode &= ~MODE_CURSOR;
 
-	keys = options_get_number(&wp->window->options, "mode-keys");
+	keys = options_number(&wp->window->options, OPTC_MODE_KEYS);
 	if (keys == MODEKEY_EMACS)
 		mode_key_init(&data->mdata, &mode_key_tree_emacs_choice);
 	else
@@ -183,16 +183,16 @@ window_more_write_line(
 	size_t	 			 size;
 	int				 utf8flag;
 
-	utf8flag = options_get_number(&wp->window->options, "utf8");
+	utf8flag = options_number(&wp->window->options, OPTC_UTF8);
 	memcpy(&gc, &grid_default_cell, sizeof gc);
 
 	if (py == 0) {
 		size = xsnprintf(hdr, sizeof hdr,
 		    "[%u/%u]", data->top, ARRAY_LENGTH(&data->list));
 		screen_write_cursormove(ctx, screen_size_x(s) - size, 0);
-		colour_set_fg(&gc, options_get_number(oo, "mode-fg"));
-		colour_set_bg(&gc, options_get_number(oo, "mode-bg"));
-		gc.attr |= options_get_number(oo, "mode-attr");
+		colour_set_fg(&gc, options_number(oo, OPTC_MODE_FG));
+		colour_set_bg(&gc, options_number(oo, OPTC_MODE_BG));
+		gc.attr |= options_number(oo, OPTC_MODE_ATTR);
 		screen_write_puts(ctx, &gc, "%s", hdr);
 		memcpy(&gc, &grid_default_cell, sizeof gc);
 	} else
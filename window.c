@@ -28,6 +28,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <termios.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "tmux.h"
@@ -42,6 +43,12 @@
  * input_parse (in input.c). Input data is received as key codes and written
  * directly via input_key.
  *
+ * At most INPUT_BUDGET bytes of output are parsed from a pane at once. A pane
+ * with more waiting is put on the pending list and stops reading from its pty;
+ * each time round the server loop, the pending panes are taken in turn and
+ * given another budget each, so one busy pane cannot hold up the others or
+ * the clients.
+ *
  * Each pane also has a "virtual" screen (screen.c) which contains the current
  * state and is redisplayed when the window is reattached to a client.
  *
@@ -54,8 +61,12 @@
 /* Global window list. */
 struct windows windows;
 
+/* Panes with output left to parse. */
+struct window_panes pending_panes = TAILQ_HEAD_INITIALIZER(pending_panes);
+
 void	window_pane_read_callback(struct bufferevent *, void *);
 void	window_pane_error_callback(struct bufferevent *, short, void *);
+void	window_pane_unqueue(struct window_pane *);
 
 RB_GENERATE(winlinks, winlink, entry, winlink_cmp);
 
@@ -228,6 +239,7 @@ window_create1(u_int sx, u_int sy)
 	queue_window_name(w);
 
 	options_init(&w->options, &global_w_options);
+	w->cache.generation = 0;
 
 	for (i = 0; i < ARRAY_LENGTH(&windows); i++) {
 		if (ARRAY_ITEM(&windows, i) == NULL) {
@@ -291,6 +303,31 @@ window_destroy(struct window *w)
 	xfree(w);
 }
 
+/* Get cached window options, refreshing them if any option has changed. */
+const struct window_cache *
+window_cache(struct window *w)
+{
+	struct window_cache	*wc = &w->cache;
+	struct options		*oo = &w->options;
+
+	if (wc->generation == options_generation)
+		return (wc);
+	wc->generation = options_generation;
+
+	wc->utf8 = options_number(oo, OPTC_UTF8);
+	wc->alternate_screen = options_number(oo, OPTC_ALTERNATE_SCREEN);
+	wc->synchronize_panes = options_number(oo, OPTC_SYNCHRONIZE_PANES);
+	wc->mode_keys = options_number(oo, OPTC_MODE_KEYS);
+	wc->mode_mouse = options_number(oo, OPTC_MODE_MOUSE);
+
+	memcpy(&wc->mode_gc, &grid_default_cell, sizeof wc->mode_gc);
+	colour_set_fg(&wc->mode_gc, options_number(oo, OPTC_MODE_FG));
+	colour_set_bg(&wc->mode_gc, options_number(oo, OPTC_MODE_BG));
+	wc->mode_gc.attr |= options_number(oo, OPTC_MODE_ATTR);
+
+	return (wc);
+}
+
 void
 window_resize(struct window *w, u_int sx, u_int sy)
 {
@@ -437,6 +474,8 @@ window_pane_create(struct window *w, u_int sx, u_int sy, u_int hlimit)
 
 	wp->saved_grid = NULL;
 
+	wp->view_time = time(NULL);
+
 	screen_init(&wp->base, sx, sy, hlimit);
 	wp->screen = &wp->base;
 
@@ -448,6 +487,7 @@ window_pane_create(struct window *w, u_int sx, u_int sy, u_int hlimit)
 void
 window_pane_destroy(struct window_pane *wp)
 {
+	window_pane_unqueue(wp);
 	if (wp->fd != -1) {
 		close(wp->fd);
 		bufferevent_free(wp->event);
@@ -487,6 +527,7 @@ window_pane_spawn(struct window_pane *wp, const char *cmd, const char *shell,
 	struct termios		 tio2;
 	u_int		 	 i;
 
+	window_pane_unqueue(wp);
 	if (wp->fd != -1) {
 		close(wp->fd);
 		bufferevent_free(wp->event);
@@ -667,12 +708,60 @@ window_pane_parse(struct window_pane *wp)
 	new_size = EVBUFFER_LENGTH(wp->event->input) - wp->pipe_off;
 	if (wp->pipe_fd != -1 && new_size > 0) {
 		data = EVBUFFER_DATA(wp->event->input);
-		bufferevent_write(wp->pipe_event, data, new_size);
+		bufferevent_write(wp->pipe_event, data + wp->pipe_off, new_size);
 	}
 
-	input_parse(wp);
+	input_parse(wp, INPUT_BUDGET);
 
 	wp->pipe_off = EVBUFFER_LENGTH(wp->event->input);
+	if (wp->pipe_off == 0) {
+		window_pane_unqueue(wp);
+		return;
+	}
+
+	/* Stop reading until the rest has been parsed. */
+	bufferevent_disable(wp->event, EV_READ);
+	if (!(wp->flags & PANE_PENDING)) {
+		TAILQ_INSERT_TAIL(&pending_panes, wp, pending_entry);
+		wp->flags |= PANE_PENDING;
+	}
+}
+
+/*
+ * Give each pending pane one more budget, in order. Panes that still have
+ * output left go back on the end of the list. Frozen panes are dropped and
+ * their output is picked up by server_window_loop once they are thawed.
+ */
+void
+window_pane_parse_pending(void)
+{
+	struct window_pane	*wp, *last;
+
+	if ((last = TAILQ_LAST(&pending_panes, window_panes)) == NULL)
+		return;
+	do {
+		wp = TAILQ_FIRST(&pending_panes);
+		window_pane_unqueue(wp);
+		if (!(wp->flags & PANE_FREEZE))
+			window_pane_parse(wp);
+	} while (wp != last);
+}
+
+/* Parse all output left in a pane, such as when it is about to close. */
+void
+window_pane_drain(struct window_pane *wp)
+{
+	while (EVBUFFER_LENGTH(wp->event->input) != 0)
+		window_pane_parse(wp);
+}
+
+void
+window_pane_unqueue(struct window_pane *wp)
+{
+	if (wp->flags & PANE_PENDING) {
+		TAILQ_REMOVE(&pending_panes, wp, pending_entry);
+		wp->flags &= ~PANE_PENDING;
+	}
 }
 
 void
@@ -692,7 +781,7 @@ window_pane_key(struct window_pane *wp, struct client *c, int key)
 	if (wp->fd == -1)
 		return;
 	input_key(wp, key);
-	if (options_get_number(&wp->window->options, "synchronize-panes")) {
+	if (window_cache(wp->window)->synchronize_panes) {
 		TAILQ_FOREACH(wp2, &wp->window->panes, entry) {
 			if (wp2 == wp || wp2->mode != NULL)
 				continue;
@@ -26,6 +26,9 @@
 
 #include "tmux.h"
 
+/* Number of allocations, for statistics. */
+uint64_t	xmalloc_count;
+
 char *
 xstrdup(const char *s)
 {
@@ -50,6 +53,7 @@ xcalloc(size_t nmemb, size_t size)
 		fatalx("nmemb * size > SIZE_MAX");
 	if ((ptr = calloc(nmemb, size)) == NULL)
 		fatal("xcalloc failed");
+	xmalloc_count++;
 
 	return (ptr);
 }
@@ -63,6 +67,7 @@ xmalloc(size_t size)
 		fatalx("zero size");
 	if ((ptr = malloc(size)) == NULL)
 		fatal("xmalloc failed");
+	xmalloc_count++;
 
 	return (ptr);
 }
@@ -79,6 +84,7 @@ xrealloc(void *oldptr, size_t nmemb, size_t size)
 		fatalx("nmemb * size > SIZE_MAX");
 	if ((newptr = realloc(oldptr, newsize)) == NULL)
 		fatal("xrealloc failed");
+	xmalloc_count++;
 
 	return (newptr);
 }
@@ -112,6 +118,7 @@ xvasprintf(char **ret, const char *fmt, va_list ap)
 	i = vasprintf(ret, fmt, ap);
 	if (i < 0 || *ret == NULL)
 		fatal("xvasprintf failed");
+	xmalloc_count++;
 
 	return (i);
 }